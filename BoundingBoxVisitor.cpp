@@ -29,33 +29,72 @@ void BoundingBoxVisitor::visit(Node &n)
     modelview_ *= transform_local;
 }
 
+bool BoundingBoxVisitor::cached(Node &n)
+{
+    // the box of the node is still valid if neither the node nor its children
+    // changed, and if it is seen with the same modelview
+    if ( n.bbox_cache_.changed > 0 && n.bbox_cache_.changed == n.changed()
+         && n.bbox_cache_.modelview == modelview_ ) {
+        bbox_.extend(n.bbox_cache_.box);
+        return true;
+    }
+    return false;
+}
+
+void BoundingBoxVisitor::cache(Node &n, const GlmToolkit::AxisAlignedBoundingBox &box)
+{
+    n.bbox_cache_.box = box;
+    n.bbox_cache_.modelview = modelview_;
+    n.bbox_cache_.changed = n.changed();
+}
+
 void BoundingBoxVisitor::visit(Group &n)
 {
-    if (!n.visible_)
+    if (!n.visible_ || cached(n))
         return;
+
+    // compute the box of the group alone
+    GlmToolkit::AxisAlignedBoundingBox box = bbox_;
+    bbox_ = GlmToolkit::AxisAlignedBoundingBox();
+
     glm::mat4 mv = modelview_;
     for (NodeSet::iterator node = n.begin(); node != n.end(); node++) {
         if ( (*node)->visible_ )
             (*node)->accept(*this);
         modelview_ = mv;
     }
+
+    cache(n, bbox_);
+    box.extend(bbox_);
+    bbox_ = box;
 }
 
 void BoundingBoxVisitor::visit(Switch &n)
 {
-    if (!n.visible_ || n.numChildren() < 1)
+    if (!n.visible_ || n.numChildren() < 1 || cached(n))
         return;
+
+    // compute the box of the switch alone
+    GlmToolkit::AxisAlignedBoundingBox box = bbox_;
+    bbox_ = GlmToolkit::AxisAlignedBoundingBox();
+
     glm::mat4 mv = modelview_;
     n.activeChild()->accept(*this);
     modelview_ = mv;
+
+    cache(n, bbox_);
+    box.extend(bbox_);
+    bbox_ = box;
 }
 
 void BoundingBoxVisitor::visit(Primitive &n)
 {
-    if (!n.visible_)
+    if (!n.visible_ || cached(n))
         return;
 
-    bbox_.extend(n.bbox().transformed(modelview_));
+    GlmToolkit::AxisAlignedBoundingBox box = n.bbox().transformed(modelview_);
+    cache(n, box);
+    bbox_.extend(box);
 
 //    Log::Info("visitor box (%f, %f)-(%f, %f)", bbox_.min().x, bbox_.min().y, bbox_.max().x, bbox_.max().y);
 }
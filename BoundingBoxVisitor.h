@@ -5,11 +5,23 @@
 #include "Visitor.h"
 
 
+/**
+ * @brief The BoundingBoxVisitor class computes the bounding box of nodes
+ *
+ * The box of every group, switch and primitive visited is kept in the node
+ * and used again by the next visitors with the same modelview, as long
+ * as the node did not change (see Node::changed()). Only the nodes which
+ * moved, were shown or hidden, or had children attached or detached since
+ * the last update are visited again.
+ */
 class BoundingBoxVisitor: public Visitor
 {
     glm::mat4 modelview_;
     GlmToolkit::AxisAlignedBoundingBox bbox_;
 
+    bool cached(Node &n);
+    void cache(Node &n, const GlmToolkit::AxisAlignedBoundingBox &box);
+
 public:
 
     BoundingBoxVisitor();
@@ -9,8 +9,32 @@
 #include "ImageShader.h"
 #include "GlmToolkit.h"
 #include "Resource.h"
+#include "InstanceBatch.h"
 #include "Log.h"
 
+// draw the meshes shared by decorations as instances of a batch when possible
+static void drawInstance(Mesh *mesh, glm::mat4 modelview, glm::mat4 projection)
+{
+    if ( !mesh->initialized() )
+        mesh->init();
+    if ( !InstanceBatch::manager().add(mesh, modelview, mesh->shader()->color, mesh->texture()) )
+        mesh->draw(modelview, projection);
+}
+
+static void drawInstance(LineStrip *line, glm::mat4 modelview, glm::mat4 projection)
+{
+    // same as LineStrip::draw : one instance per unit of line width
+    static glm::mat4 scale = glm::scale(glm::identity<glm::mat4>(), glm::vec3(1.001f, 1.001f, 1.f));
+    glm::mat4 mv = modelview;
+    for (uint i = 0 ; i < line->getLineWidth() ; ++i ) {
+        if ( !InstanceBatch::manager().add(line, mv, line->shader()->color) ) {
+            line->draw(modelview, projection);
+            return;
+        }
+        mv *= scale;
+    }
+}
+
 
 Frame::Frame(CornerType corner, BorderType border, ShadowType shadow) : Node(), side_(nullptr), top_(nullptr), shadow_(nullptr), square_(nullptr)
 {
@@ -105,19 +129,19 @@ void Frame::draw(glm::mat4 modelview, glm::mat4 projection)
         // shadow (scaled)
         if(shadow_){
             shadow_->shader()->color.a = 0.98f;
-            shadow_->draw( ctm, projection);
+            drawInstance( shadow_, ctm, projection);
         }
 
         // top (scaled)
         if(top_) {
             top_->shader()->color = color;
-            top_->draw( ctm, projection);
+            drawInstance( top_, ctm, projection);
         }
 
         // top (scaled)
         if(square_) {
             square_->shader()->color = color;
-            square_->draw( ctm, projection);
+            drawInstance( square_, ctm, projection);
         }
 
         if(side_) {
@@ -136,11 +160,11 @@ void Frame::draw(glm::mat4 modelview, glm::mat4 projection)
 
                 // left side
                 vec = ctm * glm::vec4(1.f, 0.f, 0.f, 1.f);
-                side_->draw( GlmToolkit::transform(vec, rot, glm::vec3(scale.y, scale.y, 1.f)), projection );
+                drawInstance( side_, GlmToolkit::transform(vec, rot, glm::vec3(scale.y, scale.y, 1.f)), projection );
 
                 // right side
                 vec = ctm * glm::vec4(-1.f, 0.f, 0.f, 1.f);
-                side_->draw( GlmToolkit::transform(vec, rot, glm::vec3(-scale.y, scale.y, 1.f)), projection );
+                drawInstance( side_, GlmToolkit::transform(vec, rot, glm::vec3(-scale.y, scale.y, 1.f)), projection );
 
             }
         }
@@ -224,56 +248,56 @@ void Handles::draw(glm::mat4 modelview, glm::mat4 projection)
             // 4 corners
             vec = modelview * glm::vec4(1.f, -1.f, 0.f, 1.f);
             ctm = GlmToolkit::transform(vec, rot, glm::vec3(1.f));
-            handle_->draw( ctm, projection );
+            drawInstance( handle_, ctm, projection );
 
             vec = modelview * glm::vec4(1.f, 1.f, 0.f, 1.f);
             ctm = GlmToolkit::transform(vec, rot, glm::vec3(1.f));
-            handle_->draw( ctm, projection );
+            drawInstance( handle_, ctm, projection );
 
             vec = modelview * glm::vec4(-1.f, -1.f, 0.f, 1.f);
             ctm = GlmToolkit::transform(vec, rot, glm::vec3(1.f));
-            handle_->draw( ctm, projection );
+            drawInstance( handle_, ctm, projection );
 
             vec = modelview * glm::vec4(-1.f, 1.f, 0.f, 1.f);
             ctm = GlmToolkit::transform(vec, rot, glm::vec3(1.f));
-            handle_->draw( ctm, projection );
+            drawInstance( handle_, ctm, projection );
 
             if ( glm::length(corner_) > 0.f ) {
                 vec = modelview * glm::vec4(corner_.x, corner_.y, 0.f, 1.f);
                 ctm = GlmToolkit::transform(vec, rot, glm::vec3(1.f));
-                handle_active->draw( ctm, projection );
+                drawInstance( handle_active, ctm, projection );
             }
         }
         else if ( type_ == Handles::RESIZE_H ){
             // left and right
             vec = modelview * glm::vec4(1.f, 0.f, 0.f, 1.f);
             ctm = GlmToolkit::transform(vec, rot, glm::vec3(1.f));
-            handle_->draw( ctm, projection );
+            drawInstance( handle_, ctm, projection );
 
             vec = modelview * glm::vec4(-1.f, 0.f, 0.f, 1.f);
             ctm = GlmToolkit::transform(vec, rot, glm::vec3(1.f));
-            handle_->draw( ctm, projection );
+            drawInstance( handle_, ctm, projection );
 
             if ( glm::length(corner_) > 0.f ) {
                 vec = modelview * glm::vec4(corner_.x, corner_.y, 0.f, 1.f);
                 ctm = GlmToolkit::transform(vec, rot, glm::vec3(1.f));
-                handle_active->draw( ctm, projection );
+                drawInstance( handle_active, ctm, projection );
             }
         }
         else if ( type_ == Handles::RESIZE_V ){
             // top and bottom
             vec = modelview * glm::vec4(0.f, 1.f, 0.f, 1.f);
             ctm = GlmToolkit::transform(vec, rot, glm::vec3(1.f));
-            handle_->draw( ctm, projection );
+            drawInstance( handle_, ctm, projection );
 
             vec = modelview * glm::vec4(0.f, -1.f, 0.f, 1.f);
             ctm = GlmToolkit::transform(vec, rot, glm::vec3(1.f));
-            handle_->draw( ctm, projection );
+            drawInstance( handle_, ctm, projection );
 
             if ( glm::length(corner_) > 0.f ) {
                 vec = modelview * glm::vec4(corner_.x, corner_.y, 0.f, 1.f);
                 ctm = GlmToolkit::transform(vec, rot, glm::vec3(1.f));
-                handle_active->draw( ctm, projection );
+                drawInstance( handle_active, ctm, projection );
             }
         }
         else if ( type_ == Handles::ROTATE ){
@@ -285,8 +309,8 @@ void Handles::draw(glm::mat4 modelview, glm::mat4 projection)
             vec = ( modelview * glm::vec4(1.f, 1.f, 0.f, 1.f) ) + pos;
             ctm = GlmToolkit::transform(vec, rot, glm::vec3(1.f));
             // 3. draw
-            shadow_->draw( ctm, projection );
-            handle_->draw( ctm, projection );
+            drawInstance( shadow_, ctm, projection );
+            drawInstance( handle_, ctm, projection );
         }
         else if ( type_ == Handles::SCALE ){
             // one icon in bottom right corner
@@ -297,8 +321,8 @@ void Handles::draw(glm::mat4 modelview, glm::mat4 projection)
             vec = ( modelview * glm::vec4(1.f, -1.f, 0.f, 1.f) ) + pos;
             ctm = GlmToolkit::transform(vec, rot, glm::vec3(mirror.x, mirror.y, 1.f));
             // 3. draw
-            shadow_->draw( ctm, projection );
-            handle_->draw( ctm, projection );
+            drawInstance( shadow_, ctm, projection );
+            drawInstance( handle_, ctm, projection );
         }
         else if ( type_ == Handles::MENU ){
             // one icon in top left corner
@@ -309,8 +333,8 @@ void Handles::draw(glm::mat4 modelview, glm::mat4 projection)
             vec = ( modelview * glm::vec4(-1.f, 1.f, 0.f, 1.f) ) + pos;
             ctm = GlmToolkit::transform(vec, rot, glm::vec3(1.f));
             // 3. draw
-            shadow_->draw( ctm, projection );
-            handle_->draw( ctm, projection );
+            drawInstance( shadow_, ctm, projection );
+            drawInstance( handle_, ctm, projection );
         }
     }
 }
@@ -397,8 +421,8 @@ void Symbol::draw(glm::mat4 modelview, glm::mat4 projection)
         // generate matrix
         ctm = GlmToolkit::transform(tran, rot, sca);
 
-        shadow_->draw( ctm, projection );
-        symbol_->draw( ctm, projection);
+        drawInstance( shadow_, ctm, projection );
+        drawInstance( symbol_, ctm, projection);
     }
 }
 
@@ -438,7 +462,7 @@ void Disk::draw(glm::mat4 modelview, glm::mat4 projection)
         Disk::disk_->shader()->color = color;
 
         glm::mat4 ctm = modelview * transform_;
-        Disk::disk_->draw( ctm, projection);
+        drawInstance( Disk::disk_, ctm, projection);
 
     }
 }
@@ -0,0 +1,266 @@
+#include <map>
+#include <mutex>
+
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "defines.h"
+#include "Resource.h"
+#include "FrameBuffer.h"
+#include "Primitives.h"
+#include "EffectChain.h"
+
+const char* EffectChain::builtin_names[5] = { "Grayscale", "Sepia", "Pixelate", "Vignette", "Scanlines" };
+static const char* builtin_files[5] = { "shaders/effects/grayscale.glsl", "shaders/effects/sepia.glsl",
+                                        "shaders/effects/pixelate.glsl", "shaders/effects/vignette.glsl",
+                                        "shaders/effects/scanlines.glsl" };
+
+std::string EffectChain::builtin(int index)
+{
+    if (index < 0 || index > 4)
+        return "";
+    return Resource::getText(builtin_files[index]);
+}
+
+std::string EffectChain::templateCode()
+{
+    return Resource::getText("shaders/effects/template.glsl");
+}
+
+// one program for all passes with the same code, deleted when no pass uses it
+// (passes are also created by session loading threads)
+struct EffectProgram {
+    ShadingProgram *program;
+    uint users;
+};
+static std::map<std::string, EffectProgram> effectPrograms_;
+static std::mutex effectProgramsLock_;
+
+static ShadingProgram *acquireEffectProgram(const std::string &code)
+{
+    std::lock_guard<std::mutex> lock(effectProgramsLock_);
+
+    auto it = effectPrograms_.find(code);
+    if (it != effectPrograms_.end()) {
+        it->second.users++;
+        return it->second.program;
+    }
+
+    EffectProgram p;
+    p.program = new ShadingProgram("shaders/image.vs", "shaders/effect.fs", "", code);
+    p.users = 1;
+    effectPrograms_[code] = p;
+    return p.program;
+}
+
+// the binary of the program on disk is removed if the code was replaced
+// (edited), but kept if its passes are deleted (e.g. session closed)
+static void releaseEffectProgram(const std::string &code, bool replaced = false)
+{
+    std::lock_guard<std::mutex> lock(effectProgramsLock_);
+
+    auto it = effectPrograms_.find(code);
+    if (it != effectPrograms_.end() && --(it->second.users) < 1) {
+        if (replaced)
+            it->second.program->removeBinary();
+        it->second.program->release();
+        delete it->second.program;
+        effectPrograms_.erase(it);
+    }
+}
+
+class EffectShader : public Shader
+{
+public:
+    EffectShader() : Shader(), time(0.f), frame(0)
+    {
+        reset();
+        // overwrite target (no blending)
+        blending = BLEND_CUSTOM;
+    }
+
+    void setProgram(ShadingProgram *p) { program_ = p; }
+
+    void use() override
+    {
+        Shader::use();
+        program_->setUniform("iTime", time);
+        program_->setUniform("iFrame", frame);
+    }
+
+    float time;
+    int frame;
+};
+
+
+EffectPass::EffectPass(const std::string &n, const std::string &code) : name(n), enabled(true),
+    code_(code), query_(0), query_pending_(false), gputime_(0.f)
+{
+    program_ = acquireEffectProgram(code_);
+}
+
+EffectPass::~EffectPass()
+{
+    releaseEffectProgram(code_);
+    if (query_)
+        glDeleteQueries(1, &query_);
+}
+
+void EffectPass::setCode(const std::string &code)
+{
+    // acquire new program before releasing the previous (same code)
+    ShadingProgram *program = acquireEffectProgram(code);
+    releaseEffectProgram(code_, code != code_);
+    code_ = code;
+    program_ = program;
+}
+
+bool EffectPass::valid() const
+{
+    // not compiled yet is not an error
+    return !program_->initialized() || program_->valid();
+}
+
+
+EffectChain::EffectChain() : frame_(0)
+{
+    buffers_[0] = buffers_[1] = nullptr;
+    shader_ = new EffectShader;
+    surface_ = new Surface(shader_);
+    start_ = std::chrono::steady_clock::now();
+}
+
+EffectChain::~EffectChain()
+{
+    clear();
+    release();
+    // this also deletes the shader
+    delete surface_;
+}
+
+EffectPass *EffectChain::add(const std::string &name, const std::string &code)
+{
+    EffectPass *p = new EffectPass(name, code);
+    passes_.push_back(p);
+    return p;
+}
+
+void EffectChain::remove(size_t i)
+{
+    if (i < passes_.size()) {
+        delete passes_[i];
+        passes_.erase(passes_.begin() + i);
+    }
+}
+
+void EffectChain::swap(size_t i, size_t j)
+{
+    if (i < passes_.size() && j < passes_.size())
+        std::swap(passes_[i], passes_[j]);
+}
+
+void EffectChain::clear()
+{
+    for (auto it = passes_.begin(); it != passes_.end(); it++)
+        delete *it;
+    passes_.clear();
+}
+
+bool EffectChain::operator == (const EffectChain &other) const
+{
+    std::vector<std::string> a, b;
+    for (auto it = passes_.begin(); it != passes_.end(); it++)
+        if ((*it)->enabled) a.push_back((*it)->code());
+    for (auto it = other.passes_.begin(); it != other.passes_.end(); it++)
+        if ((*it)->enabled) b.push_back((*it)->code());
+    return a == b;
+}
+
+void EffectChain::release()
+{
+    for (int i = 0; i < 2; ++i) {
+        if (buffers_[i])
+            delete buffers_[i];
+        buffers_[i] = nullptr;
+    }
+}
+
+size_t EffectChain::memory() const
+{
+    size_t m = 0;
+    for (int i = 0; i < 2; ++i) {
+        if (buffers_[i])
+            m += buffers_[i]->memory();
+    }
+    return m;
+}
+
+uint EffectChain::apply(uint texture, glm::ivec2 resolution)
+{
+    // draw the surface upside down to keep the orientation
+    // of the texture (Surface UV are flipped vertically)
+    static glm::mat4 projection = glm::scale(glm::identity<glm::mat4>(), glm::vec3(1.f, -1.f, 1.f));
+
+    shader_->time = std::chrono::duration<float>(std::chrono::steady_clock::now() - start_).count();
+    shader_->frame = frame_++;
+
+    int target = 0;
+    bool rendered = false;
+    for (auto it = passes_.begin(); it != passes_.end(); it++) {
+        EffectPass *p = *it;
+        if ( !p->enabled )
+            continue;
+
+        // compile on first use, and ignore pass if code is wrong
+        if ( !p->program_->initialized() )
+            p->program_->init();
+        if ( !p->program_->valid() )
+            continue;
+
+        // frame buffer of output
+        if ( buffers_[target] == nullptr )
+            buffers_[target] = new FrameBuffer(resolution.x, resolution.y, true);
+        else if ( (int) buffers_[target]->width() != resolution.x || (int) buffers_[target]->height() != resolution.y )
+            buffers_[target]->resize( glm::vec3(resolution, 0.f) );
+
+        // read GPU time of previous measure, without waiting for it
+        if ( p->query_pending_ ) {
+            GLint available = 0;
+            glGetQueryObjectiv(p->query_, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                GLuint64 elapsed = 0;
+                glGetQueryObjectui64v(p->query_, GL_QUERY_RESULT, &elapsed);
+                p->gputime_ = float(elapsed) * 1e-6f;
+                p->query_pending_ = false;
+            }
+        }
+        bool measure = !p->query_pending_;
+        if (measure) {
+            if ( !p->query_ )
+                glGenQueries(1, &p->query_);
+            glBeginQuery(GL_TIME_ELAPSED, p->query_);
+        }
+
+        // render pass
+        shader_->setProgram(p->program_);
+        surface_->setTextureIndex(texture);
+        buffers_[target]->begin();
+        surface_->draw(glm::identity<glm::mat4>(), projection);
+        buffers_[target]->end();
+
+        if (measure) {
+            glEndQuery(GL_TIME_ELAPSED);
+            p->query_pending_ = true;
+        }
+
+        // output is input of next pass
+        texture = buffers_[target]->texture();
+        target = 1 - target;
+        rendered = true;
+    }
+
+    if (!rendered)
+        release();
+
+    return texture;
+}
@@ -0,0 +1,105 @@
+#ifndef EFFECTCHAIN_H
+#define EFFECTCHAIN_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <glm/glm.hpp>
+
+class FrameBuffer;
+class Surface;
+class ShadingProgram;
+class EffectShader;
+
+/**
+ * @brief The EffectPass class is one pass of an EffectChain
+ *
+ * The code of a pass is a GLSL function with the ShaderToy convention
+ *
+ *     void mainImage( out vec4 fragColor, in vec2 fragCoord )
+ *
+ * reading the image of the previous pass in iChannel0, with the output
+ * resolution in iResolution (see shaders/effect.fs).
+ */
+class EffectPass
+{
+    friend class EffectChain;
+
+public:
+    EffectPass(const std::string &name, const std::string &code);
+    ~EffectPass();
+
+    std::string name;
+    bool enabled;
+
+    // change code (compiled at next rendering)
+    inline std::string code() const { return code_; }
+    void setCode(const std::string &code);
+
+    // false if the code failed to compile
+    bool valid() const;
+
+    // GPU time of the last measured rendering (milliseconds)
+    inline float gpuTime() const { return gputime_; }
+
+private:
+    std::string code_;
+    ShadingProgram *program_;
+    uint query_;
+    bool query_pending_;
+    float gputime_;
+};
+
+/**
+ * @brief The EffectChain class renders a list of effect passes on a texture
+ *
+ * Passes are rendered in order, in two frame buffers used alternately
+ * as input and output (from the GpuPool). Programs are compiled once for
+ * all chains using the same code (and deleted when no pass uses this code
+ * anymore, e.g. after edition), and their binary is kept on disk
+ * (see ShadingProgram::setBinaryCache) to load chains without compiling;
+ * the binary of a code replaced by edition is removed.
+ */
+class EffectChain
+{
+public:
+    EffectChain();
+    ~EffectChain();
+
+    // passes, rendered in order
+    inline size_t size() const { return passes_.size(); }
+    inline EffectPass *pass(size_t i) const { return passes_[i]; }
+    EffectPass *add(const std::string &name, const std::string &code);
+    void remove(size_t i);
+    void swap(size_t i, size_t j);
+    void clear();
+
+    // true if the enabled passes have the same code
+    bool operator == (const EffectChain &other) const;
+
+    // render the enabled passes on the texture at the given resolution
+    // and return the index of the resulting texture
+    uint apply(uint texture, glm::ivec2 resolution);
+
+    // give back the frame buffers (when no pass is enabled)
+    void release();
+
+    // GPU memory used (frame buffers)
+    size_t memory() const;
+
+    // built-in effects
+    static const char* builtin_names[5];
+    static std::string builtin(int index);
+    // code to start a custom effect
+    static std::string templateCode();
+
+private:
+    std::vector<EffectPass *> passes_;
+    FrameBuffer *buffers_[2];
+    Surface *surface_;
+    EffectShader *shader_;
+    std::chrono::steady_clock::time_point start_;
+    int frame_;
+};
+
+#endif // EFFECTCHAIN_H
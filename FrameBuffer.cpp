@@ -3,6 +3,7 @@
 #include "Resource.h"
 #include "Settings.h"
 #include "Log.h"
+#include "GpuPool.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -42,15 +43,9 @@ FrameBuffer::FrameBuffer(uint width, uint height, bool useAlpha, bool multiSampl
 
 void FrameBuffer::init()
 {
-    // generate texture
-    glGenTextures(1, &textureid_);
-    glBindTexture(GL_TEXTURE_2D, textureid_);
-    glTexStorage2D(GL_TEXTURE_2D, 1, use_alpha_ ? GL_RGBA8 : GL_RGB8, attrib_.viewport.x, attrib_.viewport.y);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // get texture from the pool
+    textureid_ = GpuPool::manager().acquireTexture(attrib_.viewport.x, attrib_.viewport.y,
+                                                    use_alpha_ ? GL_RGBA8 : GL_RGB8);
 
     // create a framebuffer object
     glGenFramebuffers(1, &framebufferid_);
@@ -61,16 +56,10 @@ void FrameBuffer::init()
 
     if (use_multi_sampling_){
 
-        // create a multisample texture
-        glGenTextures(1, &intermediate_textureid_);
-        glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, intermediate_textureid_);
-        glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, Settings::application.render.multisampling,
-                                use_alpha_ ? GL_RGBA8 : GL_RGB8, attrib_.viewport.x, attrib_.viewport.y, GL_TRUE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+        // get a multisample texture from the pool
+        intermediate_textureid_ = GpuPool::manager().acquireTexture(attrib_.viewport.x, attrib_.viewport.y,
+                                                                     use_alpha_ ? GL_RGBA8 : GL_RGB8,
+                                                                     Settings::application.render.multisampling);
 
         // attach the multisampled texture to FBO (framebufferid_  currently binded)
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, intermediate_textureid_, 0);
@@ -99,9 +88,38 @@ void FrameBuffer::init()
 }
 
 FrameBuffer::~FrameBuffer()
+{
+    reset();
+}
+
+void FrameBuffer::reset()
 {
     if (framebufferid_)
         glDeleteFramebuffers(1, &framebufferid_);
+    if (intermediate_framebufferid_)
+        glDeleteFramebuffers(1, &intermediate_framebufferid_);
+    framebufferid_ = intermediate_framebufferid_ = 0;
+
+    // give textures back to the pool
+    if (textureid_)
+        GpuPool::manager().releaseTexture(textureid_);
+    if (intermediate_textureid_)
+        GpuPool::manager().releaseTexture(intermediate_textureid_);
+    textureid_ = intermediate_textureid_ = 0;
+}
+
+void FrameBuffer::resize(glm::vec3 resolution)
+{
+    glm::ivec2 viewport = glm::max( glm::ivec2(resolution), glm::ivec2(2, 2) );
+    if ( viewport != attrib_.viewport ) {
+        reset();
+        attrib_.viewport = viewport;
+    }
+}
+
+size_t FrameBuffer::memory() const
+{
+    return GpuPool::manager().textureMemory(textureid_) + GpuPool::manager().textureMemory(intermediate_textureid_);
 }
 
 
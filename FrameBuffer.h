@@ -35,6 +35,9 @@ public:
     inline void setClearColor(glm::vec4 color) { attrib_.clear_color = color; }
     inline glm::vec4 clearColor() const { return attrib_.clear_color; }
 
+    // change size (content is lost, GPU memory reallocated at next begin)
+    void resize(glm::vec3 resolution);
+
     // width & height
     inline uint width() const { return attrib_.viewport.x; }
     inline uint height() const { return attrib_.viewport.y; }
@@ -54,8 +57,12 @@ public:
     // index for texturing
     uint texture() const;
 
+    // GPU memory used (textures)
+    size_t memory() const;
+
 private:
     void init();
+    void reset();
     void checkFramebufferStatus();
 
     RenderingAttrib attrib_;
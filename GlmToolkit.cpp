@@ -8,6 +8,7 @@
 
 #include <chrono>
 #include <ctime>
+#include <algorithm>
 
 
 uint64_t GlmToolkit::uniqueId()
@@ -191,6 +192,93 @@ GlmToolkit::AxisAlignedBoundingBox GlmToolkit::AxisAlignedBoundingBox::transform
 }
 
 
+// maximum count of boxes in the leaves of the tree
+#define BOUNDINGBOXTREE_LEAF_SIZE 4
+
+void GlmToolkit::BoundingBoxTree::clear()
+{
+    nodes_.clear();
+    boxes_.clear();
+    indices_.clear();
+}
+
+void GlmToolkit::BoundingBoxTree::build(const std::vector<AxisAlignedBoundingBox> &boxes)
+{
+    clear();
+    boxes_ = boxes;
+    for (uint i = 0; i < boxes_.size(); ++i)
+        indices_.push_back(i);
+
+    if (!boxes_.empty())
+        build(0, boxes_.size());
+}
+
+int GlmToolkit::BoundingBoxTree::build(uint first, uint count)
+{
+    // create the node (NB: nodes_ can be reallocated when building children)
+    int index = nodes_.size();
+    nodes_.push_back(TreeNode());
+    nodes_[index].first = first;
+    nodes_[index].count = count;
+    nodes_[index].left = -1;
+    nodes_[index].right = -1;
+
+    // box of the node contains all its boxes, and box of their centers
+    AxisAlignedBoundingBox bbox, centers;
+    for (uint i = first; i < first + count; ++i) {
+        bbox.extend(boxes_[indices_[i]]);
+        centers.extend(boxes_[indices_[i]].center());
+    }
+    nodes_[index].bbox = bbox;
+
+    // split in two halves along the longest axis of centers
+    if (count > BOUNDINGBOXTREE_LEAF_SIZE) {
+        glm::vec3 extent = centers.max() - centers.min();
+        int axis = extent.x > extent.y ? 0 : 1;
+        uint half = count / 2;
+        std::nth_element(indices_.begin() + first, indices_.begin() + first + half, indices_.begin() + first + count,
+                         [this, axis](uint a, uint b) { return boxes_[a].center()[axis] < boxes_[b].center()[axis]; });
+
+        int left = build(first, half);
+        int right = build(first + half, count - half);
+        nodes_[index].left = left;
+        nodes_[index].right = right;
+    }
+
+    return index;
+}
+
+std::vector<uint> GlmToolkit::BoundingBoxTree::intersecting(const AxisAlignedBoundingBox &bb) const
+{
+    std::vector<uint> result;
+    if (nodes_.empty())
+        return result;
+
+    std::vector<int> stack;
+    stack.push_back(0);
+    while (!stack.empty()) {
+        const TreeNode &node = nodes_[stack.back()];
+        stack.pop_back();
+
+        if ( !node.bbox.intersect(bb) )
+            continue;
+
+        // leaf: test its boxes
+        if (node.left < 0) {
+            for (uint i = node.first; i < node.first + node.count; ++i) {
+                if ( boxes_[indices_[i]].intersect(bb) )
+                    result.push_back(indices_[i]);
+            }
+        }
+        else {
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+    }
+
+    return result;
+}
+
 glm::ivec2 GlmToolkit::resolutionFromDescription(int aspectratio, int height)
 {
     int ar = glm::clamp(aspectratio, 0, 5);
@@ -47,6 +47,31 @@ public:
     AxisAlignedBoundingBox transformed(glm::mat4 m) const;
 };
 
+// Bounding volume hierarchy of boxes (in 2D, ignoring z) to
+// find quickly which boxes of a list intersect a given box
+class BoundingBoxTree
+{
+    struct TreeNode {
+        AxisAlignedBoundingBox bbox;
+        uint first, count;
+        int left, right;
+    };
+    std::vector<TreeNode> nodes_;
+    std::vector<AxisAlignedBoundingBox> boxes_;
+    std::vector<uint> indices_;
+
+    int build(uint first, uint count);
+
+public:
+    // build the hierarchy of the list of boxes
+    void build(const std::vector<AxisAlignedBoundingBox> &boxes);
+    void clear();
+    inline size_t size() const { return boxes_.size(); }
+
+    // indices in the list of the boxes intersecting the given box
+    std::vector<uint> intersecting(const AxisAlignedBoundingBox &bb) const;
+};
+
 
 static const char* aspect_ratio_names[6] = { "1:1", "4:3", "3:2", "16:10", "16:9", "21:9" };
 static const char* height_names[10] = { "16", "64", "200", "320", "480", "576", "720p", "1080p", "1440", "4K" };
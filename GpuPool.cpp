@@ -0,0 +1,195 @@
+#include <algorithm>
+
+#include <glad/glad.h>
+
+#include "defines.h"
+#include "Settings.h"
+#include "SystemToolkit.h"
+#include "Log.h"
+
+#include "GpuPool.h"
+
+
+GpuPool::GpuPool() : used_(0), cached_(0), over_budget_(false)
+{
+
+}
+
+size_t GpuPool::budget() const
+{
+    return (size_t) MAXI(Settings::application.render.gpu_budget, 64) * 1048576;
+}
+
+size_t GpuPool::textureSize(uint width, uint height, uint format, uint samples)
+{
+    // RGB8 textures are stored with 4 bytes per pixel by most drivers
+    size_t bpp = (format == GL_R8) ? 1 : 4;
+    return (size_t) width * (size_t) height * bpp * (size_t) MAXI(samples, 1u);
+}
+
+bool GpuPool::recycle(Item &item)
+{
+    for (auto it = cache_.begin(); it != cache_.end(); it++) {
+        if ( it->texture == item.texture && it->width == item.width && it->height == item.height
+             && it->format == item.format && it->samples == item.samples ) {
+            item.id = it->id;
+            cached_ -= it->bytes;
+            cache_.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void GpuPool::destroy(const Item &item)
+{
+    if (item.texture)
+        glDeleteTextures(1, &item.id);
+    else
+        glDeleteBuffers(1, &item.id);
+}
+
+void GpuPool::trim(size_t needed)
+{
+    // delete least recently released resources to fit in budget
+    while ( !cache_.empty() && used_ + cached_ + needed > budget() ) {
+        cached_ -= cache_.back().bytes;
+        destroy(cache_.back());
+        cache_.pop_back();
+    }
+
+    // cannot do more than informing user
+    if ( used_ + needed > budget() ) {
+        if (!over_budget_)
+            Log::Warning("GPU memory budget exceeded (%s used of %s).",
+                         SystemToolkit::byte_to_string(used_ + needed).c_str(),
+                         SystemToolkit::byte_to_string(budget()).c_str());
+        over_budget_ = true;
+    }
+    else
+        over_budget_ = false;
+}
+
+uint GpuPool::acquireTexture(uint width, uint height, uint format, uint samples)
+{
+    Item item;
+    item.texture = true;
+    item.width = width;
+    item.height = height;
+    item.format = format;
+    item.samples = samples;
+    item.bytes = textureSize(width, height, format, samples);
+
+    GLenum target = samples > 0 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+
+    if ( recycle(item) ) {
+        glBindTexture(target, item.id);
+    }
+    else {
+        trim(item.bytes);
+
+        // create texture storage
+        glGenTextures(1, &item.id);
+        glBindTexture(target, item.id);
+        if (samples > 0)
+            glTexImage2DMultisample(target, samples, format, width, height, GL_TRUE);
+        else
+            glTexStorage2D(target, 1, format, width, height);
+    }
+
+    // default parameters
+    if (samples < 1) {
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glBindTexture(target, 0);
+
+    used_ += item.bytes;
+    textures_[item.id] = item;
+
+    return item.id;
+}
+
+uint GpuPool::acquireBuffer(uint size, uint usage)
+{
+    Item item;
+    item.texture = false;
+    item.width = size;
+    item.height = 1;
+    item.format = usage;
+    item.samples = 0;
+    item.bytes = size;
+
+    if ( !recycle(item) ) {
+        trim(item.bytes);
+
+        // create data store (not bound to any pixel transfer target)
+        glGenBuffers(1, &item.id);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, item.id);
+        glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, usage);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    used_ += item.bytes;
+    buffers_[item.id] = item;
+
+    return item.id;
+}
+
+void GpuPool::releaseTexture(uint id)
+{
+    auto it = textures_.find(id);
+    if ( it == textures_.end() ) {
+        // not given by the pool
+        if (id > 0)
+            glDeleteTextures(1, &id);
+        return;
+    }
+
+    used_ -= it->second.bytes;
+    cached_ += it->second.bytes;
+    cache_.push_front(it->second);
+    textures_.erase(it);
+
+    trim(0);
+}
+
+void GpuPool::releaseBuffer(uint id)
+{
+    auto it = buffers_.find(id);
+    if ( it == buffers_.end() ) {
+        // not given by the pool
+        if (id > 0)
+            glDeleteBuffers(1, &id);
+        return;
+    }
+
+    used_ -= it->second.bytes;
+    cached_ += it->second.bytes;
+    cache_.push_front(it->second);
+    buffers_.erase(it);
+
+    trim(0);
+}
+
+size_t GpuPool::textureMemory(uint id) const
+{
+    auto it = textures_.find(id);
+    return it == textures_.end() ? 0 : it->second.bytes;
+}
+
+size_t GpuPool::bufferMemory(uint id) const
+{
+    auto it = buffers_.find(id);
+    return it == buffers_.end() ? 0 : it->second.bytes;
+}
+
+void GpuPool::clear()
+{
+    for (auto it = cache_.begin(); it != cache_.end(); it++)
+        destroy(*it);
+    cache_.clear();
+    cached_ = 0;
+}
@@ -0,0 +1,91 @@
+#ifndef GPUPOOL_H
+#define GPUPOOL_H
+
+#include <map>
+#include <list>
+#include <sys/types.h>
+
+/**
+ * @brief The GpuPool class recycles the OpenGL textures and pixel
+ * buffer objects of frame buffers, media players and streams.
+ *
+ * Released resources are kept in the pool and given back when a resource
+ * of the same size and format is requested, instead of being deleted and
+ * reallocated. The memory used (given) and cached (kept for recycling)
+ * is limited by the budget set in Settings::application.render.gpu_budget:
+ * cached resources are deleted first (least recently released first),
+ * and a warning is issued when the resources in use exceed the budget.
+ *
+ * NB: to be used only in the thread of the OpenGL context.
+ */
+class GpuPool
+{
+    // Private Constructor
+    GpuPool();
+    GpuPool(GpuPool const& copy);            // Not Implemented
+    GpuPool& operator=(GpuPool const& copy); // Not Implemented
+
+public:
+
+    static GpuPool& manager()
+    {
+        // The only instance
+        static GpuPool _instance;
+        return _instance;
+    }
+
+    // get a 2D texture of given size and internal format (e.g. GL_RGBA8)
+    // with linear filtering and clamp to edge, or a 2D multisample texture
+    // if samples > 0
+    uint acquireTexture(uint width, uint height, uint format, uint samples = 0);
+    void releaseTexture(uint id);
+
+    // get a buffer object with a data store of the given size and usage
+    // (e.g. GL_STREAM_DRAW for a pixel unpack buffer)
+    uint acquireBuffer(uint size, uint usage);
+    void releaseBuffer(uint id);
+
+    // memory used by a texture or buffer given by the pool (0 otherwise)
+    size_t textureMemory(uint id) const;
+    size_t bufferMemory(uint id) const;
+
+    // memory (in bytes)
+    inline size_t used() const { return used_; }
+    inline size_t cached() const { return cached_; }
+    size_t budget() const;
+
+    // delete all cached resources
+    void clear();
+
+    // estimated memory of a texture
+    static size_t textureSize(uint width, uint height, uint format, uint samples = 0);
+
+private:
+
+    struct Item {
+        bool texture;
+        uint id;
+        uint width;
+        uint height;
+        uint format;
+        uint samples;
+        size_t bytes;
+    };
+
+    // resources given by the pool
+    std::map<uint, Item> textures_;
+    std::map<uint, Item> buffers_;
+
+    // released resources, most recent first
+    std::list<Item> cache_;
+
+    size_t used_;
+    size_t cached_;
+    bool over_budget_;
+
+    bool recycle(Item &item);
+    void trim(size_t needed);
+    void destroy(const Item &item);
+};
+
+#endif // GPUPOOL_H
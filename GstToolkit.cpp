@@ -1,7 +1,12 @@
 #include <sstream>
 #include <iomanip>
+#include <thread>
+#include <deque>
+#include <atomic>
+#include <condition_variable>
 using namespace std;
 
+#include "Log.h"
 #include "GstToolkit.h"
 
 string GstToolkit::time_to_string(guint64 t, time_string_mode m)
@@ -110,6 +115,16 @@ bool GstToolkit::enable_feature (string name, bool enable) {
     return true;
 }
 
+bool GstToolkit::has_feature (string name)
+{
+    GstElementFactory *factory = gst_element_factory_find (name.c_str());
+    if (!factory)
+        return false;
+
+    gst_object_unref (factory);
+    return true;
+}
+
 
 string GstToolkit::gst_version()
 {
@@ -121,3 +136,102 @@ string GstToolkit::gst_version()
 
     return oss.str();
 }
+
+// threads stopping pipelines in parallel, and delay given to each pipeline to stop
+#define PIPELINE_TEARDOWN_THREADS 2
+#define PIPELINE_TEARDOWN_TIMEOUT 5
+
+/**
+ * Reaper threads stopping and freeing the pipelines (and the guard of their
+ * callbacks) given by pipeline_teardown()
+ */
+class PipelineReaping
+{
+    std::mutex lock_;
+    std::condition_variable condition_;
+    std::deque< std::pair<GstElement *, GstToolkit::CallbackGuard *> > queue_;
+
+    void reap() {
+        std::unique_lock<std::mutex> lock(lock_);
+        while (true) {
+            if (queue_.empty()) {
+                condition_.wait(lock);
+                continue;
+            }
+            std::pair<GstElement *, GstToolkit::CallbackGuard *> p = queue_.front();
+            queue_.pop_front();
+
+            // stop unlocked (can take long for network sources or hardware decoders)
+            lock.unlock();
+            GstClockTime t = gst_util_get_timestamp ();
+            GstStateChangeReturn ret = gst_element_set_state (p.first, GST_STATE_NULL);
+            if (ret == GST_STATE_CHANGE_ASYNC) {
+                GstState state;
+                ret = gst_element_get_state (p.first, &state, NULL, PIPELINE_TEARDOWN_TIMEOUT * GST_SECOND);
+            }
+            t = gst_util_get_timestamp () - t;
+
+            if (ret == GST_STATE_CHANGE_SUCCESS || ret == GST_STATE_CHANGE_NO_PREROLL) {
+                if ( t > GST_SECOND )
+                    Log::Info("Pipeline %s took %s s to stop.", GST_OBJECT_NAME(p.first),
+                              GstToolkit::time_to_string(t, GstToolkit::TIME_STRING_MINIMAL).c_str());
+                // no streaming thread left: callbacks cannot be called anymore
+                gst_object_unref (p.first);
+                delete p.second;
+            }
+            else {
+                // streaming threads could still call back: pipeline and guard
+                // (with owner cleared) are abandoned, not to block other teardowns
+                Log::Warning("Pipeline %s did not stop in %d s; abandoned.", GST_OBJECT_NAME(p.first),
+                             PIPELINE_TEARDOWN_TIMEOUT);
+            }
+            pending_--;
+
+            lock.lock();
+        }
+    }
+
+public:
+    std::atomic<guint> pending_;
+
+    PipelineReaping() : pending_(0) {
+        for (int i = 0; i < PIPELINE_TEARDOWN_THREADS; ++i)
+            std::thread(&PipelineReaping::reap, this).detach();
+    }
+
+    void push(GstElement *pipeline, GstToolkit::CallbackGuard *guard) {
+        std::lock_guard<std::mutex> lock(lock_);
+        pending_++;
+        queue_.push_back( std::make_pair(pipeline, guard) );
+        condition_.notify_one();
+    }
+
+    static PipelineReaping& reaper() {
+        // never deleted: detached threads use it until exit
+        static PipelineReaping *reaping = new PipelineReaping;
+        return *reaping;
+    }
+};
+
+void GstToolkit::pipeline_teardown (GstElement *pipeline, CallbackGuard *guard)
+{
+    // from now on, callbacks shall not touch the owner
+    // (wait for a callback running in a streaming thread)
+    if (guard) {
+        std::lock_guard<std::mutex> lock(guard->lock);
+        guard->owner = nullptr;
+    }
+
+    if (pipeline == nullptr) {
+        delete guard;
+        return;
+    }
+
+    // give the pipeline to the reaper threads
+    PipelineReaping::reaper().push(pipeline, guard);
+}
+
+guint GstToolkit::pipeline_teardown_pending ()
+{
+    return PipelineReaping::reaper().pending_;
+}
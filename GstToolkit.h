@@ -5,6 +5,7 @@
 
 #include <string>
 #include <list>
+#include <mutex>
 
 namespace GstToolkit
 {
@@ -22,6 +23,26 @@ std::list<std::string> all_plugins();
 std::list<std::string> all_plugin_features(std::string pluginname);
 
 bool enable_feature (std::string name, bool enable);
+bool has_feature (std::string name);
+
+// user data given to the appsink callbacks of a pipeline, instead of the object
+// receiving the frames: callbacks lock the guard and ignore the frames once
+// the owner is cleared by pipeline_teardown()
+struct CallbackGuard {
+    std::mutex lock;
+    void *owner;
+    CallbackGuard(void *o) : owner(o) {}
+};
+
+// stop and free the pipeline in background threads (reaper), without
+// blocking the caller. The owner of the guard is cleared before returning,
+// once callbacks running in streaming threads are done; the guard is deleted
+// by the reaper after the pipeline stopped (guard can be NULL). A pipeline
+// which does not stop in time is abandoned, with its guard
+void pipeline_teardown (GstElement *pipeline, CallbackGuard *guard);
+// number of pipelines given to the reaper and not yet stopped
+guint pipeline_teardown_pending ();
+
 
 }
 
@@ -24,6 +24,9 @@
 #include "ImGuiToolkit.h"
 #include "GstToolkit.h"
 #include "SystemToolkit.h"
+#include "GpuPool.h"
+#include "InstanceBatch.h"
+#include "Shader.h"
 
 unsigned int textureicons = 0;
 std::map <ImGuiToolkit::font_style, ImFont*>fontmap;
@@ -857,6 +860,10 @@ void ImGuiToolkit::ShowStats(bool *p_open, int* p_corner, bool *p_timer)
             //        ImGui::Text("HiDPI (retina) %s", io.DisplayFramebufferScale.x > 1.f ? "on" : "off");
             ImGui::Text("Refresh %.1f FPS", io.Framerate);
             ImGui::Text("Memory  %s", SystemToolkit::byte_to_string( SystemToolkit::memory_usage()).c_str() );
+            ImGui::Text("Shaders %u GL calls", ShadingProgram::calls());
+            ImGui::Text("Overlay %u in %u draws", InstanceBatch::manager().instances(), InstanceBatch::manager().draws());
+            ImGui::Text("GPU     %s / %s", SystemToolkit::byte_to_string( GpuPool::manager().used() + GpuPool::manager().cached()).c_str(),
+                        SystemToolkit::byte_to_string( GpuPool::manager().budget()).c_str() );
             ImGui::PopFont();
         }
 
@@ -15,6 +15,7 @@
 #include "Primitives.h"
 #include "ImageShader.h"
 #include "ImageProcessingShader.h"
+#include "EffectChain.h"
 #include "MediaPlayer.h"
 #include "MediaSource.h"
 #include "SessionSource.h"
@@ -402,6 +403,10 @@ void ImGuiVisitor::visit (Source& s)
         width = height * s.frame()->aspectRatio();
     }
     ImGui::Image((void*)(uintptr_t) s.frame()->texture(), ImVec2(width, height));
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("%s%s\nGPU memory %s", s.frame()->info().c_str(),
+                          s.lod() > 0 ? (" (1/" + std::to_string(1 << s.lod()) + ")").c_str() : "",
+                          SystemToolkit::byte_to_string( s.memory() ).c_str());
 
     ImVec2 pos = ImGui::GetCursorPos(); // remember where we were...
 
@@ -427,6 +432,54 @@ void ImGuiVisitor::visit (Source& s)
     if (s.imageProcessingEnabled())
         s.processingShader()->accept(*this);
 
+    // effects pannel
+    EffectChain *effects = s.effects();
+    for (size_t i = 0; i < effects->size(); ++i) {
+        EffectPass *p = effects->pass(i);
+        ImGui::PushID((int) i);
+        if (ImGui::SmallButton(ICON_FA_TIMES)) {
+            std::string name = p->name;
+            effects->remove(i);
+            Action::manager().store("Effect " + name + " removed", s.id());
+            ImGui::PopID();
+            break;
+        }
+        ImGui::SameLine();
+        if (ImGui::Checkbox("##enabled", &p->enabled))
+            Action::manager().store("Effect " + p->name + (p->enabled ? " enabled" : " disabled"), s.id());
+        ImGui::SameLine();
+        if (ImGui::SmallButton(ICON_FA_CODE))
+            UserInterface::manager().editEffect(s.id(), i);
+        ImGui::SameLine();
+        if (i > 0 && ImGui::SmallButton(ICON_FA_ARROW_UP)) {
+            effects->swap(i, i - 1);
+            Action::manager().store("Effect " + p->name + " moved", s.id());
+        }
+        ImGui::SameLine();
+        ImGui::Text("%s", p->name.c_str());
+        ImGui::SameLine();
+        if (p->valid())
+            ImGui::TextDisabled("%.2f ms", p->gpuTime());
+        else
+            ImGui::TextColored(ImVec4(IMGUI_COLOR_RECORD, 1.0), "Error");
+        ImGui::PopID();
+    }
+    ImGui::SetNextItemWidth(IMGUI_RIGHT_ALIGN);
+    if (ImGui::BeginCombo("Effects", ICON_FA_PLUS " Add")) {
+        for (int b = 0; b < IM_ARRAYSIZE(EffectChain::builtin_names); ++b) {
+            if (ImGui::Selectable(EffectChain::builtin_names[b])) {
+                effects->add(EffectChain::builtin_names[b], EffectChain::builtin(b));
+                Action::manager().store("Effect " + std::string(EffectChain::builtin_names[b]) + " added", s.id());
+            }
+        }
+        if (ImGui::Selectable("Custom")) {
+            effects->add("Custom", EffectChain::templateCode());
+            Action::manager().store("Effect Custom added", s.id());
+            UserInterface::manager().editEffect(s.id(), effects->size() - 1);
+        }
+        ImGui::EndCombo();
+    }
+
     // geometry direct control
 //    s.groupNode(View::GEOMETRY)->accept(*this);
 //    s.groupNode((View::Mode) Settings::application.current_view)->accept(*this);
@@ -0,0 +1,132 @@
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "defines.h"
+#include "FrameBuffer.h"
+#include "Primitives.h"
+#include "ImageFilter.h"
+
+static ShadingProgram filterShadingProgram("shaders/image.vs", "shaders/filter.fs");
+
+class FilterShader : public Shader
+{
+public:
+    FilterShader() : Shader(), radius(0), operation(0)
+    {
+        program_ = &filterShadingProgram;
+        reset();
+        // overwrite target (no blending)
+        blending = BLEND_CUSTOM;
+    }
+
+    void use() override
+    {
+        Shader::use();
+        program_->setUniform("direction", direction.x, direction.y);
+        program_->setUniform("radius", radius);
+        program_->setUniform("operation", operation);
+    }
+
+    glm::vec2 direction;
+    int radius;
+    int operation;
+};
+
+
+ImageFilter::ImageFilter()
+{
+    shader_ = new FilterShader;
+    surface_ = new Surface(shader_);
+}
+
+ImageFilter::~ImageFilter()
+{
+    release();
+    // this also deletes the shader
+    delete surface_;
+}
+
+void ImageFilter::release()
+{
+    for (auto it = buffers_.begin(); it != buffers_.end(); it++)
+        delete *it;
+    buffers_.clear();
+}
+
+size_t ImageFilter::memory() const
+{
+    size_t m = 0;
+    for (auto it = buffers_.begin(); it != buffers_.end(); it++)
+        m += (*it)->memory();
+    return m;
+}
+
+FrameBuffer *ImageFilter::buffer(uint level, uint index, glm::ivec2 resolution)
+{
+    resolution = glm::max( resolution / (1 << level), glm::ivec2(1, 1) );
+
+    size_t i = 2 * level + index;
+    while (buffers_.size() <= i)
+        buffers_.push_back( nullptr );
+
+    if (buffers_[i] == nullptr)
+        buffers_[i] = new FrameBuffer(resolution.x, resolution.y, true);
+    else if ( (int) buffers_[i]->width() != resolution.x || (int) buffers_[i]->height() != resolution.y )
+        buffers_[i]->resize( glm::vec3(resolution, 0.f) );
+
+    return buffers_[i];
+}
+
+void ImageFilter::pass(uint texture, FrameBuffer *target, glm::vec2 direction, int radius, int operation)
+{
+    shader_->direction = direction;
+    shader_->radius = radius;
+    shader_->operation = operation;
+    surface_->setTextureIndex(texture);
+
+    // draw the surface to cover the frame buffer, upside down to keep
+    // the orientation of the texture (Surface UV are flipped vertically)
+    static glm::mat4 projection = glm::scale(glm::identity<glm::mat4>(), glm::vec3(1.f, -1.f, 1.f));
+    target->begin();
+    surface_->draw(glm::identity<glm::mat4>(), projection);
+    target->end();
+}
+
+uint ImageFilter::apply(uint texture, int filterid, glm::ivec2 resolution)
+{
+    int radius = 0;
+    int operation = 0;
+    if (filterid == 1)
+        radius = 1;
+    else if (filterid > 5 && filterid < 9) {
+        radius = filterid - 5;
+        operation = 1;
+    }
+    else if (filterid > 8 && filterid < 12) {
+        radius = filterid - 8;
+        operation = 2;
+    }
+    else if (filterid > 11 && filterid < 15)
+        radius = 4 << (filterid - 12);
+    else
+        return texture;
+
+    // downsample for large blur, until the radius is not more than 4 pixels
+    uint level = 0;
+    while (operation == 0 && radius > 4) {
+        ++level;
+        radius /= 2;
+        FrameBuffer *down = buffer(level, 0, resolution);
+        pass(texture, down, glm::vec2(0.f), 0, 0);
+        texture = down->texture();
+    }
+
+    // separable filter : horizontal then vertical pass
+    FrameBuffer *h = buffer(level, 1, resolution);
+    FrameBuffer *v = buffer(level, 0, resolution);
+    glm::vec2 step = 1.f / glm::vec2(h->width(), h->height());
+    pass(texture, h, glm::vec2(step.x, 0.f), radius, operation);
+    pass(h->texture(), v, glm::vec2(0.f, step.y), radius, operation);
+
+    return v->texture();
+}
@@ -0,0 +1,49 @@
+#ifndef IMAGEFILTER_H
+#define IMAGEFILTER_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+class FrameBuffer;
+class Surface;
+class FilterShader;
+
+/**
+ * @brief The ImageFilter class renders the multi-pass filters of the
+ * ImageProcessingShader (see ImageProcessingShader::multipass)
+ *
+ * Blur, erosion and dilation are separable: they are rendered in a
+ * horizontal pass followed by a vertical pass of 2 x radius + 1 texture
+ * fetches each, instead of a single pass of (2 x radius + 1)^2 fetches.
+ * Large blurs are rendered on a downsampled copy of the image: each level
+ * of the chain halves the resolution, and the radius in pixels.
+ *
+ * The result is given as a texture to use in place of the input texture.
+ */
+class ImageFilter
+{
+public:
+    ImageFilter();
+    ~ImageFilter();
+
+    // render the filter of the texture at the given resolution
+    // and return the index of the filtered texture
+    uint apply(uint texture, int filterid, glm::ivec2 resolution);
+
+    // give back the frame buffers (when filter is not used)
+    void release();
+
+    // GPU memory used (frame buffers)
+    size_t memory() const;
+
+private:
+    // ping-pong frame buffers for each level of resolution
+    std::vector<FrameBuffer *> buffers_;
+    FrameBuffer *buffer(uint level, uint index, glm::ivec2 resolution);
+
+    Surface *surface_;
+    FilterShader *shader_;
+    void pass(uint texture, FrameBuffer *target, glm::vec2 direction, int radius, int operation);
+};
+
+#endif // IMAGEFILTER_H
@@ -1,21 +1,56 @@
+#include <cstring>
+#include <map>
+#include <atomic>
+
+#include <glad/glad.h>
+
 #include "defines.h"
 #include "Visitor.h"
 #include "Log.h"
+#include "RenderingManager.h"
 #include "ImageProcessingShader.h"
 
-ShadingProgram imageProcessingShadingProgram("shaders/image.vs", "shaders/imageprocessing.fs");
+// preprocessor defines enabling the features in imageprocessing.fs
+static std::string feature_defines(uint features)
+{
+    static const char* names[11] = { "FILTER_KERNEL", "FILTER_OPENING", "CHROMAKEY", "INVERT_RGB", "INVERT_LUMA",
+                                     "HUESHIFT", "SATURATION", "POSTERIZE", "LUMAKEY", "THRESHOLD", "LEVELS" };
+    std::string defines;
+    for (uint i = 0; i < 11; ++i) {
+        if ( features & (1 << i) )
+            defines += std::string("#define ") + names[i] + "\n";
+    }
+    return defines;
+}
+
+// generic program, with all features
+ShadingProgram imageProcessingShadingProgram("shaders/image.vs", "shaders/imageprocessing.fs",
+                                             feature_defines(ImageProcessingShader::FEATURE_ALL));
+
+// program variants, created on demand and compiled in background
+struct ProgramVariant {
+    ShadingProgram *program;
+    std::atomic<bool> ready;
+};
+static std::map<uint, ProgramVariant *> program_variants_;
 
-const char* ImageProcessingShader::filter_names[12] = { "None", "Blur", "Sharpen", "Edge", "Emboss", "Denoising",
-                                                        "Erosion 3x3", "Erosion 5x5", "Erosion 7x7", "Dilation 3x3", "Dilation 5x5", "Dilation 7x7" };
+const char* ImageProcessingShader::filter_names[15] = { "None", "Blur", "Sharpen", "Edge", "Emboss", "Denoising",
+                                                        "Erosion 3x3", "Erosion 5x5", "Erosion 7x7", "Dilation 3x3", "Dilation 5x5", "Dilation 7x7",
+                                                        "Blur 9x9", "Blur 17x17", "Blur 33x33" };
+
+bool ImageProcessingShader::multipass(int filterid)
+{
+    return filterid == 1 || (filterid > 5 && filterid < 15);
+}
 
 
-ImageProcessingShader::ImageProcessingShader(): Shader()
+ImageProcessingShader::ImageProcessingShader(): Shader(), ubo_(0)
 {
     program_ = &imageProcessingShadingProgram;
     reset();
 }
 
-ImageProcessingShader::ImageProcessingShader(const ImageProcessingShader &S): Shader()
+ImageProcessingShader::ImageProcessingShader(const ImageProcessingShader &S): Shader(), ubo_(0)
 {
     program_ = &imageProcessingShadingProgram;
     reset();
@@ -34,26 +69,113 @@ ImageProcessingShader::ImageProcessingShader(const ImageProcessingShader &S): Sh
     chromadelta = S.chromadelta;
 }
 
-void ImageProcessingShader::use()
+ImageProcessingShader::~ImageProcessingShader()
 {
-    Shader::use();
+    if (ubo_)
+        glDeleteBuffers(1, &ubo_);
+}
 
-    program_->setUniform("brightness", brightness);
-    program_->setUniform("contrast", contrast);
-    program_->setUniform("saturation", saturation);
-    program_->setUniform("hueshift", hueshift);
+uint ImageProcessingShader::features() const
+{
+    uint f = 0;
+
+    if (filterid > 1 && filterid < 5)
+        f |= FEATURE_FILTER_KERNEL;
+    else if (filterid == 5)
+        f |= FEATURE_FILTER_OPENING;
+
+    if (chromadelta > 0.0001f)
+        f |= FEATURE_CHROMAKEY;
+    if (invert == 1)
+        f |= FEATURE_INVERT_RGB;
+    else if (invert == 2)
+        f |= FEATURE_INVERT_LUMA;
+    if (hueshift != 0.f)
+        f |= FEATURE_HUESHIFT;
+    if (saturation != 0.f)
+        f |= FEATURE_SATURATION;
+    if (nbColors > 0)
+        f |= FEATURE_POSTERIZE;
+    if (lumakey > 0.000001f)
+        f |= FEATURE_LUMAKEY;
+    if (threshold > 0.000001f)
+        f |= FEATURE_THRESHOLD;
+    if (gamma != glm::vec4(1.f, 1.f, 1.f, 1.f) || levels != glm::vec4(0.f, 1.f, 0.f, 1.f))
+        f |= FEATURE_LEVELS;
+
+    return f;
+}
 
-    program_->setUniform("threshold", threshold);
-    program_->setUniform("lumakey", lumakey);
-    program_->setUniform("nbColors", nbColors);
-    program_->setUniform("invert", invert);
-    program_->setUniform("filterid", filterid);
+ShadingProgram *ImageProcessingShader::variant(uint features)
+{
+    if (features == FEATURE_ALL)
+        return &imageProcessingShadingProgram;
+
+    ProgramVariant *v = nullptr;
+    auto it = program_variants_.find(features);
+    if (it != program_variants_.end())
+        v = it->second;
+    else {
+        // first request of this variant : compile it in background
+        v = new ProgramVariant;
+        v->program = new ShadingProgram("shaders/image.vs", "shaders/imageprocessing.fs", feature_defines(features));
+        v->ready = false;
+        program_variants_[features] = v;
+        Rendering::manager().pushBackgroundTask( [v]() {
+            v->program->init();
+            glFinish();
+            v->ready = true;
+        });
+    }
+
+    // use generic program until the variant is ready
+    return v->ready ? v->program : &imageProcessingShadingProgram;
+}
 
-    program_->setUniform("gamma", gamma);
-    program_->setUniform("levels", levels);
-    program_->setUniform("chromakey", chromakey);
-    program_->setUniform("chromadelta", chromadelta);
+void ImageProcessingShader::use()
+{
+    // swap to the program specialized for the features in use
+    program_ = variant( features() );
 
+    Shader::use();
+
+    Block b;
+    b.gamma = gamma;
+    b.levels = levels;
+    b.chromakey = chromakey;
+    b.contrast = contrast;
+    b.brightness = brightness;
+    b.saturation = saturation;
+    b.hueshift = hueshift;
+    b.chromadelta = chromadelta;
+    b.threshold = threshold;
+    b.lumakey = lumakey;
+    b.nbColors = nbColors;
+    b.invert = invert;
+    b.filterid = filterid;
+    b.padding[0] = b.padding[1] = 0;
+
+    // create the uniform buffer on first use
+    if (!ubo_) {
+        glGenBuffers(1, &ubo_);
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo_);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), &b, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        ShadingProgram::count(4);
+        block_ = b;
+    }
+    // update the uniform buffer only if values changed
+    else if ( memcmp(&b, &block_, sizeof(Block)) != 0 ) {
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo_);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &b);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        ShadingProgram::count(3);
+        block_ = b;
+    }
+
+    // all parameters in one call
+    glBindBufferBase(GL_UNIFORM_BUFFER, ShadingProgram::BLOCK_IMAGEPROCESSING, ubo_);
+    ShadingProgram::count();
 }
 
 
@@ -97,6 +219,18 @@ void ImageProcessingShader::operator = (const ImageProcessingShader &S )
     chromadelta = S.chromadelta;
 }
 
+bool ImageProcessingShader::operator == (const ImageProcessingShader &S ) const
+{
+    return Shader::operator ==(S) &&
+            brightness == S.brightness && contrast == S.contrast &&
+            saturation == S.saturation && hueshift == S.hueshift &&
+            threshold == S.threshold && lumakey == S.lumakey &&
+            nbColors == S.nbColors && invert == S.invert &&
+            filterid == S.filterid && gamma == S.gamma &&
+            levels == S.levels && chromakey == S.chromakey &&
+            chromadelta == S.chromadelta;
+}
+
 
 void ImageProcessingShader::accept(Visitor& v)
 {
@@ -12,12 +12,14 @@ public:
 
     ImageProcessingShader();
     ImageProcessingShader(const ImageProcessingShader &model);
+    ~ImageProcessingShader();
 
     void use() override;
     void reset() override;
     void accept(Visitor& v) override;
 
     void operator = (const ImageProcessingShader &S);
+    bool operator == (const ImageProcessingShader &S) const;
 
     // color effects
     float brightness; // [-1 1]
@@ -40,9 +42,57 @@ public:
     // [1 4] 4 x kernel operations;  Blur, Sharpen, Edge, Emboss
     // [5] 1 x convolution opening (denoising)
     // [6 11] 6 x convolutions: erosion 3x3, 5x5, 7x7, dilation 3x3, 5x5, 7x7
+    // [12 14] 3 x large blur 9x9, 17x17, 33x33
     int filterid;
-    static const char* filter_names[12];
+    static const char* filter_names[15];
+    // true for the filters applied in multiple passes by ImageFilter
+    // before the shader (blur, erosion, dilation)
+    static bool multipass(int filterid);
 
+    // features used by the current parameters; the program used is a
+    // variant of the shader compiled only with these features
+    typedef enum {
+        FEATURE_FILTER_KERNEL   = 1 << 0,
+        FEATURE_FILTER_OPENING  = 1 << 1,
+        FEATURE_CHROMAKEY       = 1 << 2,
+        FEATURE_INVERT_RGB      = 1 << 3,
+        FEATURE_INVERT_LUMA     = 1 << 4,
+        FEATURE_HUESHIFT        = 1 << 5,
+        FEATURE_SATURATION      = 1 << 6,
+        FEATURE_POSTERIZE       = 1 << 7,
+        FEATURE_LUMAKEY         = 1 << 8,
+        FEATURE_THRESHOLD       = 1 << 9,
+        FEATURE_LEVELS          = 1 << 10,
+        FEATURE_ALL             = (1 << 11) - 1
+    } Feature;
+    uint features() const;
+
+private:
+    // get the program variant for the given features
+    // (the generic program while the variant is compiled in background)
+    static ShadingProgram *variant(uint features);
+
+    // parameters in the std140 layout of the uniform block
+    // 'ImageProcessing' of the shader imageprocessing.fs
+    struct Block {
+        glm::vec4 gamma;
+        glm::vec4 levels;
+        glm::vec4 chromakey;
+        float contrast;
+        float brightness;
+        float saturation;
+        float hueshift;
+        float chromadelta;
+        float threshold;
+        float lumakey;
+        int   nbColors;
+        int   invert;
+        int   filterid;
+        int   padding[2];
+    };
+    // uniform buffer object, updated only if the values changed
+    Block block_;
+    uint ubo_;
 };
 
 
@@ -6,6 +6,7 @@
 #include "Resource.h"
 
 static ShadingProgram imageShadingProgram("shaders/image.vs", "shaders/image.fs");
+static ShadingProgram imageInstancedShadingProgram("shaders/instanced.vs", "shaders/image.fs");
 
 const char* ImageShader::mask_names[11] = { "None", "Glow", "Halo", "Circle", "Round", "Vignette", "Top", "Botton", "Left", "Right", "Custom" };
 std::vector< uint > ImageShader::mask_presets;
@@ -15,15 +16,15 @@ ImageShader::ImageShader(): Shader(), mask(0), custom_textureindex(0), stipple(0
     // first initialization
     if ( mask_presets.empty() ) {
         mask_presets.push_back(Resource::getTextureWhite());
-        mask_presets.push_back(Resource::getTextureImage("images/mask_glow.png"));
-        mask_presets.push_back(Resource::getTextureImage("images/mask_halo.png"));
-        mask_presets.push_back(Resource::getTextureImage("images/mask_circle.png"));
-        mask_presets.push_back(Resource::getTextureImage("images/mask_roundcorner.png"));
-        mask_presets.push_back(Resource::getTextureImage("images/mask_vignette.png"));
-        mask_presets.push_back(Resource::getTextureImage("images/mask_linear_top.png"));
-        mask_presets.push_back(Resource::getTextureImage("images/mask_linear_bottom.png"));
-        mask_presets.push_back(Resource::getTextureImage("images/mask_linear_left.png"));
-        mask_presets.push_back(Resource::getTextureImage("images/mask_linear_right.png"));
+        mask_presets.push_back(Resource::getTextureImageAsync("images/mask_glow.png"));
+        mask_presets.push_back(Resource::getTextureImageAsync("images/mask_halo.png"));
+        mask_presets.push_back(Resource::getTextureImageAsync("images/mask_circle.png"));
+        mask_presets.push_back(Resource::getTextureImageAsync("images/mask_roundcorner.png"));
+        mask_presets.push_back(Resource::getTextureImageAsync("images/mask_vignette.png"));
+        mask_presets.push_back(Resource::getTextureImageAsync("images/mask_linear_top.png"));
+        mask_presets.push_back(Resource::getTextureImageAsync("images/mask_linear_bottom.png"));
+        mask_presets.push_back(Resource::getTextureImageAsync("images/mask_linear_left.png"));
+        mask_presets.push_back(Resource::getTextureImageAsync("images/mask_linear_right.png"));
     }
     // static program shader
     program_ = &imageShadingProgram;
@@ -35,7 +36,7 @@ void ImageShader::use()
 {
     Shader::use();
 
-    program_->setUniform("stipple", stipple);
+    program_->setUniform(ShadingProgram::UNIFORM_STIPPLE, stipple);
 
     glActiveTexture(GL_TEXTURE1);
     if ( mask < 10 )
@@ -46,6 +47,7 @@ void ImageShader::use()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
     glActiveTexture(GL_TEXTURE0);
+    ShadingProgram::count(5);
 
 }
 
@@ -70,7 +72,18 @@ void ImageShader::operator = (const ImageShader &S )
 }
 
 
+bool ImageShader::operator == (const ImageShader &S ) const
+{
+    return Shader::operator ==(S) && mask == S.mask &&
+            custom_textureindex == S.custom_textureindex && stipple == S.stipple;
+}
+
 void ImageShader::accept(Visitor& v) {
     Shader::accept(v);
     v.visit(*this);
 }
+
+ShadingProgram *ImageShader::instancedProgram() const
+{
+    return program_ == &imageShadingProgram ? &imageInstancedShadingProgram : nullptr;
+}
@@ -20,8 +20,10 @@ public:
     void use() override;
     void reset() override;
     void accept(Visitor& v) override;
+    ShadingProgram *instancedProgram() const override;
 
     void operator = (const ImageShader &S);
+    bool operator == (const ImageShader &S) const;
 
     uint mask;
     uint custom_textureindex;
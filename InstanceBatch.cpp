@@ -0,0 +1,181 @@
+#include <glad/glad.h>
+
+#include "Scene.h"
+#include "Shader.h"
+
+#include "InstanceBatch.h"
+
+// per-instance attributes follow the vertex attributes of Primitive
+// (0 position, 1 color, 2 texture coordinates):
+// 3 to 6 for the columns of the modelview matrix, 7 for the color
+#define INSTANCE_ATTRIB 3
+#define INSTANCE_ATTRIB_COUNT 5
+
+
+InstanceBatch::InstanceBatch() : projection_(glm::mat4(1.f)), buffer_(0), active_(false),
+    instances_(0), draws_(0), last_instances_(0), last_draws_(0)
+{
+
+}
+
+bool InstanceBatch::Batch::overlap(const GlmToolkit::AxisAlignedBoundingBox &box) const
+{
+    if ( !bbox.intersect(box) )
+        return false;
+
+    for (auto b = boxes.begin(); b != boxes.end(); b++) {
+        if ( b->intersect(box) )
+            return true;
+    }
+    return false;
+}
+
+void InstanceBatch::begin(glm::mat4 projection)
+{
+    // draw what could be left from a previous begin
+    if (active_)
+        flush();
+
+    projection_ = projection;
+    active_ = true;
+}
+
+void InstanceBatch::end()
+{
+    flush();
+    active_ = false;
+}
+
+void InstanceBatch::endFrame()
+{
+    last_instances_ = instances_;
+    last_draws_ = draws_;
+    instances_ = 0;
+    draws_ = 0;
+}
+
+bool InstanceBatch::add(Primitive *p, glm::mat4 modelview, glm::vec4 color, uint texture)
+{
+    if ( !active_ || p == nullptr || p->shader() == nullptr || p->shader()->instancedProgram() == nullptr )
+        return false;
+
+    if ( !p->initialized() )
+        p->init();
+
+    // nothing to draw (but nothing to draw directly either)
+    if ( !p->visible_ || p->vao_ == 0 )
+        return true;
+
+    // cannot know where it would be drawn
+    if ( p->bbox_.isNull() )
+        return false;
+
+    Instance instance;
+    instance.modelview = modelview * p->transform_;
+    instance.color = color;
+    GlmToolkit::AxisAlignedBoundingBox box = p->bbox_.transformed(instance.modelview);
+
+    // look for the last batch of this primitive, going back in drawing order
+    // as long as the instance does not overlap the instances queued after it
+    Batch *batch = nullptr;
+    for (auto b = batches_.rbegin(); b != batches_.rend(); b++) {
+        if ( b->primitive == p && b->texture == texture ) {
+            batch = &(*b);
+            break;
+        }
+        if ( b->overlap(box) )
+            break;
+    }
+
+    // start a new batch at the end
+    if ( batch == nullptr ) {
+        batches_.push_back(Batch());
+        batch = &batches_.back();
+        batch->primitive = p;
+        batch->texture = texture;
+    }
+
+    batch->instances.push_back(instance);
+    batch->boxes.push_back(box);
+    batch->bbox.extend(box);
+    instances_++;
+
+    return true;
+}
+
+void InstanceBatch::barrier(const GlmToolkit::AxisAlignedBoundingBox &box)
+{
+    if ( batches_.empty() )
+        return;
+
+    // unknown extent: keep drawing order
+    if ( box.isNull() ) {
+        flush();
+        return;
+    }
+
+    for (auto b = batches_.begin(); b != batches_.end(); b++) {
+        if ( b->overlap(box) ) {
+            flush();
+            return;
+        }
+    }
+}
+
+void InstanceBatch::flush()
+{
+    if ( batches_.empty() )
+        return;
+
+    // upload instances of all batches in one buffer
+    data_.clear();
+    for (auto b = batches_.begin(); b != batches_.end(); b++)
+        data_.insert(data_.end(), b->instances.begin(), b->instances.end());
+
+    if ( buffer_ == 0 )
+        glGenBuffers(1, &buffer_);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+    glBufferData(GL_ARRAY_BUFFER, data_.size() * sizeof(Instance), data_.data(), GL_STREAM_DRAW);
+
+    // keep the texture bound by the primitive which caused the flush
+    GLint texture = 0;
+    glActiveTexture(GL_TEXTURE0);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+
+    size_t offset = 0;
+    for (auto b = batches_.begin(); b != batches_.end(); b++) {
+
+        // use the instanced program of the shader, colors given by instances
+        Shader *s = b->primitive->shader();
+        glm::vec4 color = s->color;
+        s->color = glm::vec4(1.f);
+        s->projection = projection_;
+        glBindTexture(GL_TEXTURE_2D, b->texture);
+        s->useInstanced();
+        s->color = color;
+
+        // per-instance attributes read from the offset of the batch
+        glBindVertexArray( b->primitive->vao_ );
+        for (uint i = 0; i < INSTANCE_ATTRIB_COUNT; ++i) {
+            glVertexAttribPointer(INSTANCE_ATTRIB + i, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                                  (void *)(offset + i * sizeof(glm::vec4)) );
+            glVertexAttribDivisor(INSTANCE_ATTRIB + i, 1);
+            glEnableVertexAttribArray(INSTANCE_ATTRIB + i);
+        }
+
+        glDrawElementsInstanced( b->primitive->drawMode_, b->primitive->drawCount_, GL_UNSIGNED_INT, 0,
+                                 b->instances.size() );
+
+        for (uint i = 0; i < INSTANCE_ATTRIB_COUNT; ++i)
+            glDisableVertexAttribArray(INSTANCE_ATTRIB + i);
+        glBindVertexArray(0);
+
+        offset += b->instances.size() * sizeof(Instance);
+        draws_++;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    batches_.clear();
+}
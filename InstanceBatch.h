@@ -0,0 +1,92 @@
+#ifndef INSTANCEBATCH_H
+#define INSTANCEBATCH_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "GlmToolkit.h"
+
+class Primitive;
+
+/**
+ * @brief The InstanceBatch class draws the primitives shared by the
+ * decorations of views (meshes of Frame, Handles, Symbol and Disk)
+ * with one instanced draw call per primitive.
+ *
+ * Between begin() and end(), the decorations add() an instance of their
+ * primitive (modelview and color) instead of drawing it. Instances of
+ * the same primitive are grouped in a batch, each batch being drawn
+ * in end() with the instanced version of the shader program of
+ * the primitive (per-instance modelview and color attributes).
+ *
+ * Drawing order is kept where it matters: an instance joins the previous
+ * batch of its primitive only if it does not overlap an instance queued
+ * after that batch, and any other primitive drawn during traversal
+ * first flushes the pending batches if it overlaps one of them.
+ *
+ * NB: to be used only in the thread of the OpenGL context.
+ */
+class InstanceBatch
+{
+    // Private Constructor
+    InstanceBatch();
+    InstanceBatch(InstanceBatch const& copy);            // Not Implemented
+    InstanceBatch& operator=(InstanceBatch const& copy); // Not Implemented
+
+public:
+
+    static InstanceBatch& manager()
+    {
+        // The only instance
+        static InstanceBatch _instance;
+        return _instance;
+    }
+
+    // start collecting instances to draw with the given projection
+    void begin(glm::mat4 projection);
+    // draw all pending instances and stop collecting
+    void end();
+    inline bool active() const { return active_; }
+
+    // queue an instance of the primitive, with the texture bound.
+    // Returns false if the primitive cannot be batched (not collecting,
+    // or no instanced program for its shader): it shall be drawn directly
+    bool add(Primitive *p, glm::mat4 modelview, glm::vec4 color, uint texture = 0);
+
+    // draw the pending instances if they overlap the given box (in modelview
+    // coordinates) of a primitive to be drawn directly
+    void barrier(const GlmToolkit::AxisAlignedBoundingBox &box);
+
+    // count of instances and of draw calls in the last frame ended by endFrame()
+    void endFrame();
+    inline uint instances() const { return last_instances_; }
+    inline uint draws() const { return last_draws_; }
+
+private:
+
+    struct Instance {
+        glm::mat4 modelview;
+        glm::vec4 color;
+    };
+
+    struct Batch {
+        Primitive *primitive;
+        uint texture;
+        std::vector<Instance> instances;
+        std::vector<GlmToolkit::AxisAlignedBoundingBox> boxes;
+        GlmToolkit::AxisAlignedBoundingBox bbox;
+        bool overlap(const GlmToolkit::AxisAlignedBoundingBox &box) const;
+    };
+
+    std::vector<Batch> batches_;
+    std::vector<Instance> data_;
+    glm::mat4 projection_;
+    uint buffer_;
+    bool active_;
+    uint instances_, draws_;
+    uint last_instances_, last_draws_;
+
+    void flush();
+};
+
+#endif // INSTANCEBATCH_H
@@ -1,4 +1,7 @@
 #include <thread>
+#include <deque>
+#include <condition_variable>
+#include <functional>
 
 using namespace std;
 
@@ -13,6 +16,7 @@ using namespace std;
 #include "Visitor.h"
 #include "SystemToolkit.h"
 #include "GlmToolkit.h"
+#include "GpuPool.h"
 
 #include "MediaPlayer.h"
 
@@ -31,6 +35,8 @@ MediaPlayer::MediaPlayer()
 
     uri_ = "undefined";
     pipeline_ = nullptr;
+    bus_ = nullptr;
+    guard_ = nullptr;
 
     ready_ = false;
     failed_ = false;
@@ -41,6 +47,12 @@ MediaPlayer::MediaPlayer()
     desired_state_ = GST_STATE_PAUSED;
     loop_ = LoopMode::LOOP_REWIND;
 
+    // no gap crossing
+    segment_ = false;
+    crossing_from_ = GST_CLOCK_TIME_NONE;
+    frame_time_ = GST_CLOCK_TIME_NONE;
+    gap_stall_ = 0;
+
     // start index in frame_ stack
     write_index_ = 0;
     last_index_ = 0;
@@ -183,6 +195,56 @@ static MediaInfo UriDiscoverer_(std::string uri)
     return video_stream_info;
 }
 
+/**
+ * Pool of threads discovering media in parallel (as many threads as cores),
+ * the future result of each discovery being checked in MediaPlayer::update()
+ */
+class MediaDiscovering
+{
+    std::mutex lock_;
+    std::condition_variable condition_;
+    std::deque< std::packaged_task<MediaInfo()> > queue_;
+
+    void discover() {
+        std::unique_lock<std::mutex> lock(lock_);
+        while (true) {
+            if (queue_.empty()) {
+                condition_.wait(lock);
+                continue;
+            }
+            std::packaged_task<MediaInfo()> task = std::move(queue_.front());
+            queue_.pop_front();
+
+            // discover unlocked
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+public:
+    MediaDiscovering() {
+        uint n = MAXI(std::thread::hardware_concurrency(), 2u);
+        for (uint i = 0; i < n; ++i)
+            std::thread(&MediaDiscovering::discover, this).detach();
+    }
+
+    std::future<MediaInfo> push(const std::string &uri) {
+        std::packaged_task<MediaInfo()> task( std::bind(UriDiscoverer_, uri) );
+        std::future<MediaInfo> info = task.get_future();
+        std::lock_guard<std::mutex> lock(lock_);
+        queue_.push_back( std::move(task) );
+        condition_.notify_one();
+        return info;
+    }
+
+    static MediaDiscovering& pool() {
+        // never deleted: detached threads use it until exit
+        static MediaDiscovering *discovering = new MediaDiscovering;
+        return *discovering;
+    }
+};
+
 void MediaPlayer::open(string path)
 {
     // set path
@@ -196,8 +258,8 @@ void MediaPlayer::open(string path)
     // reset
     ready_ = false;
 
-    // start URI discovering thread:
-    discoverer_ = std::async( UriDiscoverer_, uri_);
+    // discover URI in the pool of threads:
+    discoverer_ = MediaDiscovering::pool().push(uri_);
 
     // wait for discoverer to finish in the future (test in update)
 }
@@ -272,6 +334,9 @@ void MediaPlayer::execute_open()
         gst_app_sink_set_max_buffers( GST_APP_SINK(sink), 50);
         gst_app_sink_set_drop (GST_APP_SINK(sink), true);
 
+        // callbacks are given a guard of this media player (see close)
+        guard_ = new GstToolkit::CallbackGuard(this);
+
 #ifdef USE_GST_APPSINK_CALLBACKS
         // set the callbacks
         GstAppSinkCallbacks callbacks;
@@ -284,13 +349,13 @@ void MediaPlayer::execute_open()
             callbacks.eos = callback_end_of_stream;
             callbacks.new_sample = callback_new_sample;
         }
-        gst_app_sink_set_callbacks (GST_APP_SINK(sink), &callbacks, this, NULL);
+        gst_app_sink_set_callbacks (GST_APP_SINK(sink), &callbacks, guard_, NULL);
         gst_app_sink_set_emit_signals (GST_APP_SINK(sink), false);
 #else
         // connect signals callbacks
-        g_signal_connect(G_OBJECT(sink), "new-sample", G_CALLBACK (callback_new_sample), this);
-        g_signal_connect(G_OBJECT(sink), "new-preroll", G_CALLBACK (callback_new_preroll), this);
-        g_signal_connect(G_OBJECT(sink), "eos", G_CALLBACK (callback_end_of_stream), this);
+        g_signal_connect(G_OBJECT(sink), "new-sample", G_CALLBACK (callback_new_sample), guard_);
+        g_signal_connect(G_OBJECT(sink), "new-preroll", G_CALLBACK (callback_new_preroll), guard_);
+        g_signal_connect(G_OBJECT(sink), "eos", G_CALLBACK (callback_end_of_stream), guard_);
         gst_app_sink_set_emit_signals (GST_APP_SINK(sink), true);
 #endif
         // done with ref to sink
@@ -306,6 +371,9 @@ void MediaPlayer::execute_open()
     // capture bus signals to force a unique opengl context for all GST elements 
     //Rendering::LinkPipeline(GST_PIPELINE (pipeline));
 
+    // bus to get end of segments (gaps in timeline)
+    bus_ = gst_pipeline_get_bus( GST_PIPELINE(pipeline_) );
+
     // set to desired state (PLAY or PAUSE)
     GstStateChangeReturn ret = gst_element_set_state (pipeline_, desired_state_);
     if (ret == GST_STATE_CHANGE_FAILURE) {
@@ -348,8 +416,8 @@ void MediaPlayer::close()
 {
     // not openned?
     if (!ready_  && discoverer_.valid()) {
-        // wait for loading to finish
-        discoverer_.wait();
+        // forget about discovery (does not wait for it to finish)
+        discoverer_ = std::future<MediaInfo>();
         // nothing else to change
         return;
     }
@@ -357,16 +425,16 @@ void MediaPlayer::close()
     // un-ready the media player
     ready_ = false;
 
-    // clean up GST
-    if (pipeline_ != nullptr) {
-        GstStateChangeReturn ret = gst_element_set_state (pipeline_, GST_STATE_NULL);
-        if (ret == GST_STATE_CHANGE_ASYNC) {
-            GstState state;
-            gst_element_get_state (pipeline_, &state, NULL, GST_CLOCK_TIME_NONE);
-        }
-        gst_object_unref (pipeline_);
-        pipeline_ = nullptr;
+    // clean up GST : detach callbacks and stop pipeline in background
+    GstToolkit::pipeline_teardown(pipeline_, guard_);
+    pipeline_ = nullptr;
+    guard_ = nullptr;
+    if (bus_ != nullptr) {
+        gst_object_unref (bus_);
+        bus_ = nullptr;
     }
+    segment_ = false;
+    crossing_from_ = GST_CLOCK_TIME_NONE;
 
     // cleanup eventual remaining frame memory
     for(guint i = 0; i < N_VFRAME; i++){
@@ -376,14 +444,13 @@ void MediaPlayer::close()
         }
     }
 
-    // cleanup opengl texture
+    // give back opengl texture
     if (textureindex_)
-        glDeleteTextures(1, &textureindex_);
+        GpuPool::manager().releaseTexture(textureindex_);
     textureindex_ = 0;
 
-    // cleanup picture buffer
-    if (pbo_[0])
-        glDeleteBuffers(2, pbo_);
+    // give back picture buffers
+    release_pbo();
     pbo_size_ = 0;
 
 #ifdef MEDIA_PLAYER_DEBUG
@@ -607,34 +674,42 @@ void MediaPlayer::jump()
     gst_element_send_event (pipeline_, gst_event_new_step (GST_FORMAT_BUFFERS, 1, 30.f * ABS(rate_), TRUE,  FALSE));
 }
 
+void MediaPlayer::release_pbo()
+{
+    for(int i = 0; i < 2; i++ ) {
+        if (pbo_[i])
+            GpuPool::manager().releaseBuffer(pbo_[i]);
+        pbo_[i] = 0;
+    }
+}
+
+size_t MediaPlayer::memory() const
+{
+    return GpuPool::manager().textureMemory(textureindex_) +
+            GpuPool::manager().bufferMemory(pbo_[0]) + GpuPool::manager().bufferMemory(pbo_[1]);
+}
+
 void MediaPlayer::init_texture(guint index)
 {
     glActiveTexture(GL_TEXTURE0);
-    glGenTextures(1, &textureindex_);
+    textureindex_ = GpuPool::manager().acquireTexture(media_.width, media_.height, GL_RGBA8);
     glBindTexture(GL_TEXTURE_2D, textureindex_);
-    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, media_.width, media_.height);
     glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, media_.width, media_.height,
                     GL_RGBA, GL_UNSIGNED_BYTE, frame_[index].vframe.data[0]);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
     if (!media_.isimage) {
 
         // set pbo image size
         pbo_size_ = media_.height * media_.width * 4;
 
-        // create pixel buffer objects,
-        if (pbo_[0])
-            glDeleteBuffers(2, pbo_);
-        glGenBuffers(2, pbo_);
+        // get pixel buffer objects from the pool
+        release_pbo();
+        pbo_[0] = GpuPool::manager().acquireBuffer(pbo_size_, GL_STREAM_DRAW);
+        pbo_[1] = GpuPool::manager().acquireBuffer(pbo_size_, GL_STREAM_DRAW);
 
         for(int i = 0; i < 2; i++ ) {
-            // create 2 PBOs
+            // 2 PBOs with reserved memory space
             glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_[i]);
-            // glBufferDataARB with NULL pointer reserves only memory space.
-            glBufferData(GL_PIXEL_UNPACK_BUFFER, pbo_size_, 0, GL_STREAM_DRAW);
             // fill in with reset picture
             GLubyte* ptr = (GLubyte*) glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
             if (ptr)  {
@@ -645,8 +720,7 @@ void MediaPlayer::init_texture(guint index)
             }
             else {
                 // did not work, disable PBO
-                glDeleteBuffers(2, pbo_);
-                pbo_[0] = pbo_[1] = 0;
+                release_pbo();
                 pbo_size_ = 0;
                 break;
             }
@@ -722,7 +796,7 @@ void MediaPlayer::update()
     // not ready yet
     if (!ready_ && discoverer_.valid()) {
         // try to get info from discoverer
-        if (discoverer_.wait_for( std::chrono::milliseconds(4) ) == std::future_status::ready )
+        if (discoverer_.wait_for( std::chrono::milliseconds(0) ) == std::future_status::ready )
         {
             media_ = discoverer_.get();
             // if its ok, open the media
@@ -786,6 +860,22 @@ void MediaPlayer::update()
         // we just displayed a vframe : set position time to frame PTS
         position_ = frame_[read_index].position;
 
+        // first frame after a gap: measure how much longer than
+        // a frame the previous one stayed displayed
+        GstClockTime now = gst_util_get_timestamp ();
+        if ( crossing_from_ != GST_CLOCK_TIME_NONE && position_ != GST_CLOCK_TIME_NONE
+             && ( rate_ > 0.0 ? position_ >= crossing_from_ : position_ <= crossing_from_ ) ) {
+            GstClockTime frame = static_cast<GstClockTime>( static_cast<double>(media_.timeline.step()) / ABS(rate_) );
+            GstClockTime elapsed = frame_time_ != GST_CLOCK_TIME_NONE ? now - frame_time_ : 0;
+            gap_stall_ = elapsed > frame ? elapsed - frame : 0;
+            crossing_from_ = GST_CLOCK_TIME_NONE;
+#ifdef MEDIA_PLAYER_DEBUG
+            Log::Info("MediaPlayer %s Gap crossed with %ld ms stall", std::to_string(id_).c_str(),
+                      GST_TIME_AS_MSECONDS(gap_stall_));
+#endif
+        }
+        frame_time_ = now;
+
         // avoid reading it again
         frame_[read_index].status = INVALID;
 
@@ -798,6 +888,31 @@ void MediaPlayer::update()
     // unkock frame after reading it
     frame_[read_index].access.unlock();
 
+    // end of a segment played: reached a gap
+    if (bus_ != nullptr && segment_) {
+        GstMessage *msg = gst_bus_pop_filtered (bus_, GST_MESSAGE_SEGMENT_DONE);
+        if (msg != nullptr) {
+            GstFormat format;
+            gint64 done = GST_CLOCK_TIME_NONE;
+            gst_message_parse_segment_done (msg, &format, &done);
+            gst_message_unref (msg);
+            segment_ = false;
+            // jump over the gap immediately, without flushing the frames
+            // of the segment not displayed yet
+            TimeInterval gap;
+            if ( media_.timeline.gapAt(done, gap) && gap.is_valid() ) {
+                GstClockTime jumpPts = (rate_>0.f) ? gap.end : gap.begin;
+                if (jumpPts > media_.timeline.first() && jumpPts < media_.timeline.last())
+                    cross_gap(done, false);
+                else
+                    need_loop = true;
+            }
+            // no gap anymore (timeline changed): continue
+            else
+                execute_seek_command(done, false);
+        }
+    }
+
     // if already seeking (asynch)
     if (seeking_) {
         // request status update to pipeline (re-sync gst thread)
@@ -818,7 +933,7 @@ void MediaPlayer::update()
                 GstClockTime jumpPts = (rate_>0.f) ? gap.end : gap.begin;
                 // seek to next valid time (if not beginnig or end of timeline)
                 if (jumpPts > media_.timeline.first() && jumpPts < media_.timeline.last())
-                    seek( jumpPts );
+                    cross_gap( position_, true );
                 // otherwise, we should loop
                 else
                     need_loop = true;
@@ -847,7 +962,20 @@ void MediaPlayer::execute_loop_command()
     }
 }
 
-void MediaPlayer::execute_seek_command(GstClockTime target)
+void MediaPlayer::cross_gap(GstClockTime from, bool flush)
+{
+    TimeInterval gap;
+    if ( !enabled_ || !media_.timeline.gapAt(from, gap) || !gap.is_valid() )
+        return;
+
+    // measure the stall at the first frame after the gap
+    crossing_from_ = (rate_>0.f) ? gap.end : gap.begin;
+
+    // jump in one or the other direction
+    execute_seek_command( crossing_from_, flush);
+}
+
+void MediaPlayer::execute_seek_command(GstClockTime target, bool flush)
 {
     if ( pipeline_ == nullptr || !media_.seekable )
         return;
@@ -859,33 +987,51 @@ void MediaPlayer::execute_seek_command(GstClockTime target)
     if (target == GST_CLOCK_TIME_NONE) 
         // create seek event with current position (rate changed ?)
         seek_pos = position_;
-    // target is given but useless
-    else if ( ABS_DIFF(target, position_) < media_.timeline.step()) {
+    // target is given but useless (unless continuing after a segment)
+    else if ( flush && ABS_DIFF(target, position_) < media_.timeline.step()) {
         // ignore request
         return;
     }
 
-    // seek with flush (always)
-    int seek_flags = GST_SEEK_FLAG_FLUSH;
+    // seek with flush (except to continue playing after a segment)
+    int seek_flags = flush ? GST_SEEK_FLAG_FLUSH : GST_SEEK_FLAG_NONE;
     // seek with trick mode if fast speed
     if ( ABS(rate_) > 1.0 )
         seek_flags |= GST_SEEK_FLAG_TRICKMODE;
 
+    // play only until the next gap, in a segment: the pipeline posts a
+    // segment done message at the gap (instead of playing into it)
+    TimeInterval gap;
+    bool segment = false;
+    if (rate_ > 0)
+        segment = media_.timeline.nextGap(seek_pos, gap);
+    else
+        segment = media_.timeline.previousGap(seek_pos, gap);
+    if (segment)
+        seek_flags |= GST_SEEK_FLAG_SEGMENT;
+
     // create seek event depending on direction
     GstEvent *seek_event = nullptr;
     if (rate_ > 0) {
-        seek_event = gst_event_new_seek (rate_, GST_FORMAT_TIME, (GstSeekFlags) seek_flags,
-            GST_SEEK_TYPE_SET, seek_pos, GST_SEEK_TYPE_END, 0);
+        if (segment)
+            seek_event = gst_event_new_seek (rate_, GST_FORMAT_TIME, (GstSeekFlags) seek_flags,
+                GST_SEEK_TYPE_SET, seek_pos, GST_SEEK_TYPE_SET, gap.begin);
+        else
+            seek_event = gst_event_new_seek (rate_, GST_FORMAT_TIME, (GstSeekFlags) seek_flags,
+                GST_SEEK_TYPE_SET, seek_pos, GST_SEEK_TYPE_END, 0);
     }
     else {
         seek_event = gst_event_new_seek (rate_, GST_FORMAT_TIME, (GstSeekFlags) seek_flags,
-            GST_SEEK_TYPE_SET, 0, GST_SEEK_TYPE_SET, seek_pos);
+            GST_SEEK_TYPE_SET, segment ? gap.end : 0, GST_SEEK_TYPE_SET, seek_pos);
     }
 
     // Send the event (ASYNC)
-    if (seek_event && !gst_element_send_event(pipeline_, seek_event) )
+    if (seek_event && !gst_element_send_event(pipeline_, seek_event) ) {
         Log::Warning("MediaPlayer %s Seek failed", std::to_string(id_).c_str());
+        segment_ = false;
+    }
     else {
+        segment_ = segment;
         seeking_ = true;
 #ifdef MEDIA_PLAYER_DEBUG
         Log::Info("MediaPlayer %s Seek %ld %.1f", std::to_string(id_).c_str(), seek_pos, rate_);
@@ -954,6 +1100,11 @@ double MediaPlayer::frameRate() const
     return static_cast<double>(media_.framerate_n) / static_cast<double>(media_.framerate_d);;
 }
 
+GstClockTime MediaPlayer::gapStall() const
+{
+    return gap_stall_;
+}
+
 double MediaPlayer::updateFrameRate() const
 {
     return timecount_.frameRate();
@@ -1039,7 +1190,9 @@ bool MediaPlayer::fill_frame(GstBuffer *buf, FrameStatus status)
 
 void MediaPlayer::callback_end_of_stream (GstAppSink *, gpointer p)
 {
-    MediaPlayer *m = (MediaPlayer *)p;
+    GstToolkit::CallbackGuard *guard = (GstToolkit::CallbackGuard *)p;
+    std::lock_guard<std::mutex> lock(guard->lock);
+    MediaPlayer *m = (MediaPlayer *)guard->owner;
     if (m && m->ready_) {
         m->fill_frame(NULL, MediaPlayer::EOS);
     }
@@ -1058,8 +1211,10 @@ GstFlowReturn MediaPlayer::callback_new_preroll (GstAppSink *sink, gpointer p)
         // get buffer from sample
         GstBuffer *buf = gst_sample_get_buffer (sample);
 
-        // send frames to media player only if ready
-        MediaPlayer *m = (MediaPlayer *)p;
+        // send frames to media player only if ready (and not closed)
+        GstToolkit::CallbackGuard *guard = (GstToolkit::CallbackGuard *)p;
+        std::lock_guard<std::mutex> lock(guard->lock);
+        MediaPlayer *m = (MediaPlayer *)guard->owner;
         if (m && m->ready_) {
 
             // fill frame from buffer
@@ -1093,8 +1248,10 @@ GstFlowReturn MediaPlayer::callback_new_sample (GstAppSink *sink, gpointer p)
         // get buffer from sample (valid until sample is released)
         GstBuffer *buf = gst_sample_get_buffer (sample) ;
 
-        // send frames to media player only if ready
-        MediaPlayer *m = (MediaPlayer *)p;
+        // send frames to media player only if ready (and not closed)
+        GstToolkit::CallbackGuard *guard = (GstToolkit::CallbackGuard *)p;
+        std::lock_guard<std::mutex> lock(guard->lock);
+        MediaPlayer *m = (MediaPlayer *)guard->owner;
         if (m && m->ready_) {
             // fill frame with buffer
             if ( !m->fill_frame(buf, MediaPlayer::SAMPLE) )
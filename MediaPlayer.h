@@ -12,6 +12,7 @@
 #include <gst/app/gstappsink.h>
 
 #include "Timeline.h"
+#include "GstToolkit.h"
 
 // Forward declare classes referenced
 class Visitor;
@@ -220,6 +221,11 @@ public:
      * measured during play
      * */
     double updateFrameRate() const;
+    /**
+     * Get the delay of display added by the
+     * last jump over a gap of the timeline
+     * */
+    GstClockTime gapStall() const;
     /**
      * Get frame width
      * */
@@ -238,6 +244,11 @@ public:
      * Must be called in OpenGL context
      * */
     guint texture() const;
+    /**
+     * Get the GPU memory used for texturing
+     * (texture and pixel buffer objects)
+     * */
+    size_t memory() const;
     /**
      * Accept visitors
      * Used for saving session file
@@ -269,6 +280,8 @@ private:
     LoopMode loop_;
     GstState desired_state_;
     GstElement *pipeline_;
+    GstBus *bus_;
+    GstToolkit::CallbackGuard *guard_;
     GstVideoInfo v_frame_video_info_;
     std::atomic<bool> ready_;
     std::atomic<bool> failed_;
@@ -291,6 +304,15 @@ private:
     };
     TimeCounter timecount_;
 
+    // jump over gaps of timeline: the pipeline plays segments until the
+    // next gap, and is given the next segment after the gap (without
+    // flushing) as soon as the previous is done
+    bool segment_;
+    GstClockTime crossing_from_;
+    GstClockTime frame_time_;
+    GstClockTime gap_stall_;
+    void cross_gap(GstClockTime from, bool flush);
+
     // frame stack
     typedef enum  {
         SAMPLE = 0,
@@ -325,10 +347,11 @@ private:
     // gst pipeline control
     void execute_open();
     void execute_loop_command();
-    void execute_seek_command(GstClockTime target = GST_CLOCK_TIME_NONE);
+    void execute_seek_command(GstClockTime target = GST_CLOCK_TIME_NONE, bool flush = true);
 
     // gst frame filling
     void init_texture(guint index);
+    void release_pbo();
     void fill_texture(guint index);
     bool fill_frame(GstBuffer *buf, FrameStatus status);
 
@@ -128,16 +128,19 @@ void MediaSource::render()
 //        blendingshader_->color.b = mediaplayer_->currentTimelineFading();
 
         // render the media player into frame buffer
-        renderbuffer_->begin();
 //        texturesurface_->shader()->color.a = mediaplayer_->currentTimelineFading();
         texturesurface_->shader()->color.r = mediaplayer_->currentTimelineFading();
         texturesurface_->shader()->color.g = mediaplayer_->currentTimelineFading();
         texturesurface_->shader()->color.b = mediaplayer_->currentTimelineFading();
-        texturesurface_->draw(glm::identity<glm::mat4>(), renderbuffer_->projection());
-        renderbuffer_->end();
+        renderTexture();
     }
 }
 
+size_t MediaSource::memory() const
+{
+    return Source::memory() + mediaplayer_->memory();
+}
+
 void MediaSource::accept(Visitor& v)
 {
     Source::accept(v);
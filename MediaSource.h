@@ -17,6 +17,7 @@ public:
     void render() override;
     bool failed() const override;
     uint texture() const override;
+    size_t memory() const override;
     void accept (Visitor& v) override;
 
     // Media specific interface
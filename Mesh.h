@@ -11,13 +11,19 @@
  *  PLY - Polygon File Format
  *  Also known as the Stanford Triangle Format
  *  http://paulbourke.net/dataformats/ply/
+ *
+ *  Meshes of resources are loaded from their packed version generated
+ *  at build time (mesh/name.mesh for mesh/name.ply) when available,
+ *  and parsed from the ascii or binary little endian PLY file otherwise.
  */
 class Mesh : public Primitive {
 
 public:
     Mesh(const std::string& ply_path, const std::string& tex_path = "");
+    ~Mesh();
 
     void setTexture(uint textureindex);
+    inline uint texture() const { return textureindex_; }
 
     void init () override;
     void draw (glm::mat4 modelview, glm::mat4 projection) override;
@@ -26,11 +32,20 @@ public:
     inline std::string meshPath() const { return mesh_resource_; }
     inline std::string texturePath() const { return texture_resource_; }
 
+    // use packed meshes when available (true by default)
+    static bool packed;
+    // total time (ms) spent and number of meshes loaded
+    static inline float loadingTime() { return loading_time_; }
+    static inline uint loadingCount() { return loading_count_; }
+
 protected:
     std::string mesh_resource_;
     std::string texture_resource_;
     uint textureindex_;
 
+private:
+    static float loading_time_;
+    static uint loading_count_;
 };
 
 
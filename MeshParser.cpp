@@ -0,0 +1,518 @@
+#include <sstream>
+#include <istream>
+#include <vector>
+#include <map>
+#include <utility>
+#include <cstring>
+#include <cstdio>
+#include <cstdarg>
+
+#include "MeshParser.h"
+
+using namespace std;
+using namespace glm;
+
+// OpenGL primitive types (same values as in GL/gl.h, not included here)
+#define MESH_POINTS    0x0000
+#define MESH_LINES     0x0001
+#define MESH_TRIANGLES 0x0004
+#define MESH_QUADS     0x0007
+
+// set the error message and fail
+static bool parseError(string &error, const char *fmt, ...)
+{
+    char buffer[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+    error = buffer;
+    return false;
+}
+
+typedef std::vector< std::pair< std::string, int> > plyElement;
+
+typedef enum {
+    PLY_INT8 = 0,
+    PLY_UINT8,
+    PLY_INT16,
+    PLY_UINT16,
+    PLY_INT32,
+    PLY_UINT32,
+    PLY_FLOAT32,
+    PLY_FLOAT64,
+    PLY_INVALID
+} plyType;
+
+static plyType parseType(const std::string &type)
+{
+    if (type == "char" || type == "int8")
+        return PLY_INT8;
+    if (type == "uchar" || type == "uint8")
+        return PLY_UINT8;
+    if (type == "short" || type == "int16")
+        return PLY_INT16;
+    if (type == "ushort" || type == "uint16")
+        return PLY_UINT16;
+    if (type == "int" || type == "int32")
+        return PLY_INT32;
+    if (type == "uint" || type == "uint32")
+        return PLY_UINT32;
+    if (type == "float" || type == "float32")
+        return PLY_FLOAT32;
+    if (type == "double" || type == "float64")
+        return PLY_FLOAT64;
+    return PLY_INVALID;
+}
+
+typedef struct prop {
+    std::string name;
+    plyType type;
+    plyType size_type;
+    bool is_list;
+    prop(std::string n, plyType t, plyType s = PLY_INVALID){
+        name = n;
+        type = t;
+        size_type = s;
+        is_list = s != PLY_INVALID;
+    }
+} plyProperty;
+
+typedef std::map<std::string, std::vector<plyProperty> > plyElementProperties;
+
+//float parseValue()
+template <typename T>
+static T parseValue(std::istream& istream) {
+
+    T v;
+    char space = ' ';
+    istream >> v;
+    if (!istream.eof()) {
+        istream >> space >> std::ws;
+    }
+
+    return v;
+}
+
+// read a little-endian value in binary data, and advance in data
+template <typename T>
+static double readValue(const char *&data) {
+
+    T v;
+    memcpy(&v, data, sizeof(T));
+    data += sizeof(T);
+
+    return (double) v;
+}
+
+static size_t typeSize(plyType type) {
+    static const size_t sizes[PLY_INVALID] = { 1, 1, 2, 2, 4, 4, 4, 8 };
+    return type < PLY_INVALID ? sizes[type] : 0;
+}
+
+static double readValue(const char *&data, plyType type) {
+
+    switch (type) {
+    case PLY_INT8:
+        return readValue<int8_t>(data);
+    case PLY_UINT8:
+        return readValue<uint8_t>(data);
+    case PLY_INT16:
+        return readValue<int16_t>(data);
+    case PLY_UINT16:
+        return readValue<uint16_t>(data);
+    case PLY_INT32:
+        return readValue<int32_t>(data);
+    case PLY_UINT32:
+        return readValue<uint32_t>(data);
+    case PLY_FLOAT32:
+        return readValue<float>(data);
+    case PLY_FLOAT64:
+        return readValue<double>(data);
+    default:
+        return 0.0;
+    }
+}
+
+/**
+ * @brief parsePLY
+ *
+ * Loosely inspired from libply
+ * https://web.archive.org/web/20151202190005/http://people.cs.kuleuven.be/~ares.lagae/libply/
+ *
+ * @param content content of an ascii or binary little endian PLY file
+ * @param outPositions vertices
+ * @param outColors colors
+ * @param outUV texture coordinates
+ * @param outIndices indices of faces
+ * @param outPrimitive type of faces (triangles, etc.)
+ * @param error message in case of failure
+ * @return true on success read
+ */
+bool MeshParser::parsePLY(const string &content,
+              vector<vec3> &outPositions,
+              vector<vec4> &outColors,
+              vector<vec2> &outUV,
+              vector<uint> &outIndices,
+              uint &outPrimitive,
+              string &error)
+{
+    stringstream istream(content);
+
+    std::string line;
+    int line_number_ = 0;
+
+    // magic
+    char magic[3];
+    istream.read(magic, 3);
+    istream.ignore(1);
+    ++line_number_;
+    if (!istream) {
+        return parseError(error, "Parse error line %d: not ASCII?", line_number_);
+    }
+    if ((magic[0] != 'p') || (magic[1] != 'l') || (magic[2] != 'y')){
+        return parseError(error, "Parse error line %d: not PLY format", line_number_);
+    }
+
+    plyElement elements;
+    plyElementProperties elementsProperties;
+    std::string current_element = "";
+    bool binary = false;
+
+    // parse header
+    while (std::getline(istream, line)) {
+
+        ++line_number_;
+        std::istringstream stringstream(line);
+        stringstream.unsetf(std::ios_base::skipws);
+
+        stringstream >> std::ws;
+        if (stringstream.eof()) {
+            // ignore empty line
+        }
+
+        else {
+            std::string keyword;
+            stringstream >> keyword;
+
+            // format
+            if (keyword == "format") {
+                std::string format_string, version;
+                char space_format_format_string, space_format_string_version;
+                stringstream >> space_format_format_string >> std::ws >> format_string >> space_format_string_version >> std::ws >> version >> std::ws;
+                if (!stringstream.eof() ||
+                        !std::isspace(space_format_format_string) ||
+                        !std::isspace(space_format_string_version)) {
+                    return parseError(error, "Parse error line %d: '%s'", line_number_, line.c_str());
+                }
+                if (format_string == "binary_little_endian") {
+                    binary = true;
+                }
+                else if (format_string != "ascii") {
+                    return parseError(error, "Unsupported PLY file format %s", format_string.c_str());
+                }
+                if (version != "1.0") {
+                    return parseError(error, "Unsupported PLY version %s", version.c_str());
+                }
+            }
+
+            // element
+            else if (keyword == "element") {
+                std::string name;
+                std::size_t count;
+                char space_element_name, space_name_count;
+                stringstream >> space_element_name >> std::ws >> name >> space_name_count >> std::ws >> count >> std::ws;
+                if (!stringstream.eof() ||
+                        !std::isspace(space_element_name) ||
+                        !std::isspace(space_name_count)) {
+                    return parseError(error, "Parse error line %d: '%s'", line_number_, line.c_str());
+                }
+                current_element = name;
+                elements.push_back( pair<string, int>{current_element, count} );
+            }
+
+            // property
+            else if (keyword == "property") {
+                std::string type_or_list;
+                char space_property_type_or_list;
+                stringstream >> space_property_type_or_list >> std::ws >> type_or_list;
+                if (!std::isspace(space_property_type_or_list)) {
+                    return parseError(error, "Parse error line %d: '%s'", line_number_, line.c_str());
+                }
+
+                // NOT A LIST property : i.e. a type & a name (e.g. 'property float x' )
+                if (type_or_list != "list") {
+                    std::string name;
+                    std::string& type = type_or_list;
+                    char space_type_name;
+                    stringstream >> space_type_name >> std::ws >> name >> std::ws;
+                    if (!std::isspace(space_type_name) || parseType(type) == PLY_INVALID) {
+                        return parseError(error, "Parse error line %d: '%s'", line_number_, line.c_str());
+                    }
+                    elementsProperties[current_element].push_back(plyProperty(name, parseType(type)));
+                }
+                // list property : several types & a name (e.g. 'property list uchar uint vertex_indices')
+                else {
+                    std::string name;
+                    std::string size_type_string, scalar_type_string;
+                    char space_list_size_type, space_size_type_scalar_type, space_scalar_type_name;
+                    stringstream >> space_list_size_type >> std::ws >> size_type_string >> space_size_type_scalar_type >> std::ws >> scalar_type_string >> space_scalar_type_name >> std::ws >> name >> std::ws;
+                    if (!std::isspace(space_list_size_type) ||
+                            !std::isspace(space_size_type_scalar_type) ||
+                            !std::isspace(space_scalar_type_name) ||
+                            parseType(size_type_string) == PLY_INVALID ||
+                            parseType(scalar_type_string) == PLY_INVALID) {
+                      return parseError(error, "Parse error line %d: '%s'", line_number_, line.c_str());
+                    }
+                    elementsProperties[current_element].push_back(plyProperty(name, parseType(scalar_type_string), parseType(size_type_string)));
+                }
+
+            }
+
+            // end_header
+            else if (keyword == "end_header") {
+                break;
+            }
+        }
+    } // end while readline header
+
+    // binary data follows the header
+    const char *data = nullptr;
+    const char *data_end = content.data() + content.size();
+    if (binary) {
+        std::streampos header_size = istream.tellg();
+        if (header_size < 0) {
+            return parseError(error, "Parse error: no binary data");
+        }
+        data = content.data() + (size_t) header_size;
+    }
+
+    // values of elements are read from the current line of an ascii file,
+    // or from the binary data
+    std::istringstream stringstream;
+    auto nextValue = [&](plyType type) -> double {
+        if (binary)
+            return readValue(data, type);
+        return parseValue<double>(stringstream);
+    };
+
+    uint num_vertex_per_face = 0;
+    // loop over elements
+    for (uint i=0; i< elements.size(); ++i)
+    {
+        std::string elem = elements[i].first;
+        int num_data = elements[i].second;
+        const std::vector<plyProperty> &properties = elementsProperties[elem];
+
+        // loop over lines of properties of the element
+        for (int n = 0; n < num_data; ++n )
+        {
+            if (binary) {
+                // check there is enough data for fixed size properties
+                size_t size = 0;
+                for (auto p = properties.begin(); p != properties.end(); ++p)
+                    size += typeSize( p->is_list ? p->size_type : p->type );
+                if (data + size > data_end) {
+                    return parseError(error, "Parse error: unexpected end of binary data in element %s", elem.c_str());
+                }
+            }
+            else {
+                if (!std::getline(istream, line)) {
+                    return parseError(error, "Parse error line %d: '%s'", line_number_, line.c_str());
+                }
+                ++line_number_;
+                stringstream.clear();
+                stringstream.str(line);
+                stringstream.unsetf(std::ios_base::skipws);
+                stringstream >> std::ws;
+            }
+
+            vec3 point = vec3(0.f, 0.f, 0.f);
+            vec4 color = vec4(1.f, 1.f, 1.f, 1.f);
+            vec2 uv = vec2(0.f, 0.f);
+            bool has_point = false;
+            bool has_uv = false;
+
+            // read each property of the element
+            for (uint j = 0; j < properties.size(); ++j)
+            {
+                const plyProperty &prop = properties[j];
+
+                // a numerical property
+                if ( ! prop.is_list ) {
+
+                    switch ( prop.name[0] ) {
+                    case 'x':
+                        point.x = (float) nextValue(prop.type);
+                        has_point = true;
+                        break;
+                    case 'y':
+                        point.y = (float) nextValue(prop.type);
+                        has_point = true;
+                        break;
+                    case 'z':
+                        point.z = (float) nextValue(prop.type);
+                        has_point = true;
+                        break;
+                    case 's':
+                        uv.x = (float) nextValue(prop.type);
+                        has_uv = true;
+                        break;
+                    case 't':
+                        uv.y = - (float) nextValue(prop.type);
+                        has_uv = true;
+                        break;
+                    case 'r':
+                        color.r = (float) (int) nextValue(prop.type) / 255.f;
+                        break;
+                    case 'g':
+                        color.g = (float) (int) nextValue(prop.type) / 255.f;
+                        break;
+                    case 'b':
+                        color.b = (float) (int) nextValue(prop.type) / 255.f;
+                        break;
+                    case 'a':
+                        color.a = (float) (int) nextValue(prop.type) / 255.f;
+                        break;
+                    default:
+                        // ignore normals or other types
+                        nextValue(prop.type);
+                        break;
+                    }
+                }
+                // a list property
+                else {
+                    // how many values in the list of index ?
+                    uint num_index = (uint) nextValue(prop.size_type);
+
+                    // check that the number of vertex per face is consistent
+                    if (num_vertex_per_face == 0)
+                        num_vertex_per_face = num_index;
+                    else {
+                        if (num_vertex_per_face != num_index) {
+                            return parseError(error, "Variable number of vertices per face not supported");
+                        }
+                    }
+
+                    // check there is enough binary data for the list
+                    if (binary && data + num_index * typeSize(prop.type) > data_end) {
+                        return parseError(error, "Parse error: unexpected end of binary data in element %s", elem.c_str());
+                    }
+
+                    // safely append those indices
+                    for (uint k = 0; k < num_vertex_per_face; ++k ){
+                        uint index = (uint) nextValue(prop.type);
+                        outIndices.push_back( index );
+                    }
+                }
+            }
+
+            // ok, we filled some values
+            if (has_point) {
+                outPositions.push_back(point);
+                outColors.push_back(color);
+                if (has_uv)
+                    outUV.push_back(uv);
+            }
+        }
+
+    }
+
+    switch (num_vertex_per_face) {
+    case 1:
+        outPrimitive = MESH_POINTS;
+        break;
+    case 2:
+        outPrimitive = MESH_LINES;
+        break;
+    case 3:
+        outPrimitive = MESH_TRIANGLES;
+        break;
+    case 4:
+        outPrimitive = MESH_QUADS;
+        break;
+    default:
+        return parseError(error, "Invalid number of vertices per face. Please triangulate your mesh.");
+    }
+
+    return true;
+}
+
+/**
+ * Packed meshes are generated at build time from the PLY files of
+ * resources (see cmake/tools/meshpack.cpp) : a header followed by
+ * the arrays of positions, colors, texture coordinates and indices,
+ * ready to be copied in the vectors of the Primitive.
+ */
+#define MESH_PACKED_MAGIC 0x534D5856 // "VXMS"
+#define MESH_PACKED_VERSION 1
+
+struct packedHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t primitive;
+    uint32_t num_points;
+    uint32_t num_uv;
+    uint32_t num_indices;
+};
+
+bool MeshParser::parsePacked(const char *data, size_t size,
+                 vector<vec3> &outPositions,
+                 vector<vec4> &outColors,
+                 vector<vec2> &outUV,
+                 vector<uint> &outIndices,
+                 uint &outPrimitive)
+{
+    packedHeader header;
+    if (data == nullptr || size < sizeof(packedHeader))
+        return false;
+    memcpy(&header, data, sizeof(packedHeader));
+    if (header.magic != MESH_PACKED_MAGIC || header.version != MESH_PACKED_VERSION)
+        return false;
+
+    size_t expected = sizeof(packedHeader)
+            + (size_t) header.num_points * (sizeof(vec3) + sizeof(vec4))
+            + (size_t) header.num_uv * sizeof(vec2)
+            + (size_t) header.num_indices * sizeof(uint32_t);
+    if (size != expected)
+        return false;
+
+    data += sizeof(packedHeader);
+    outPositions.resize(header.num_points);
+    memcpy(outPositions.data(), data, header.num_points * sizeof(vec3));
+    data += header.num_points * sizeof(vec3);
+    outColors.resize(header.num_points);
+    memcpy(outColors.data(), data, header.num_points * sizeof(vec4));
+    data += header.num_points * sizeof(vec4);
+    outUV.resize(header.num_uv);
+    memcpy(outUV.data(), data, header.num_uv * sizeof(vec2));
+    data += header.num_uv * sizeof(vec2);
+    outIndices.resize(header.num_indices);
+    memcpy(outIndices.data(), data, header.num_indices * sizeof(uint32_t));
+    outPrimitive = header.primitive;
+
+    return true;
+}
+
+string MeshParser::pack(const vector<vec3> &positions,
+                        const vector<vec4> &colors,
+                        const vector<vec2> &uv,
+                        const vector<uint> &indices,
+                        uint primitive)
+{
+    packedHeader header;
+    header.magic = MESH_PACKED_MAGIC;
+    header.version = MESH_PACKED_VERSION;
+    header.primitive = primitive;
+    header.num_points = (uint32_t) positions.size();
+    header.num_uv = (uint32_t) uv.size();
+    header.num_indices = (uint32_t) indices.size();
+
+    string data( (const char *) &header, sizeof(packedHeader) );
+    data.append( (const char *) positions.data(), positions.size() * sizeof(vec3) );
+    data.append( (const char *) colors.data(), colors.size() * sizeof(vec4) );
+    data.append( (const char *) uv.data(), uv.size() * sizeof(vec2) );
+    data.append( (const char *) indices.data(), indices.size() * sizeof(uint32_t) );
+
+    return data;
+}
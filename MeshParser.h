@@ -0,0 +1,45 @@
+#ifndef MESHPARSER_H
+#define MESHPARSER_H
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <glm/glm.hpp>
+
+/**
+ * Parsing of the meshes loaded by the Mesh class, without OpenGL nor
+ * logging, to be shared with the tool packing the meshes of resources
+ * at build time (cmake/tools/meshpack.cpp).
+ *
+ * The primitive type of faces is given as an OpenGL primitive
+ * (GL_POINTS, GL_LINES, GL_TRIANGLES or GL_QUADS).
+ */
+namespace MeshParser
+{
+
+// content of an ascii or binary little endian PLY file
+bool parsePLY(const std::string &content,
+              std::vector<glm::vec3> &outPositions,
+              std::vector<glm::vec4> &outColors,
+              std::vector<glm::vec2> &outUV,
+              std::vector<uint> &outIndices,
+              uint &outPrimitive,
+              std::string &error);
+
+// data of a packed mesh (as given by pack)
+bool parsePacked(const char *data, size_t size,
+                 std::vector<glm::vec3> &outPositions,
+                 std::vector<glm::vec4> &outColors,
+                 std::vector<glm::vec2> &outUV,
+                 std::vector<uint> &outIndices,
+                 uint &outPrimitive);
+
+std::string pack(const std::vector<glm::vec3> &positions,
+                 const std::vector<glm::vec4> &colors,
+                 const std::vector<glm::vec2> &uv,
+                 const std::vector<uint> &indices,
+                 uint primitive);
+
+}
+
+#endif // MESHPARSER_H
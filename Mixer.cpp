@@ -28,13 +28,15 @@ using namespace tinyxml2;
 #include "NetworkSource.h"
 #include "ActionManager.h"
 #include "Streamer.h"
+#include "Mesh.h"
+#include "TaskQueue.h"
 
 #include "Mixer.h"
 
 #define THREADED_LOADING
 static std::vector< std::future<Session *> > sessionLoaders_;
 static std::vector< std::future<Session *> > sessionImporters_;
-const std::chrono::milliseconds timeout_ = std::chrono::milliseconds(4);
+const std::chrono::milliseconds timeout_ = std::chrono::milliseconds(0);
 
 
 // static multithreaded session saving
@@ -127,18 +129,12 @@ Mixer::Mixer() : session_(nullptr), back_session_(nullptr), current_view_(nullpt
 
     // this initializes with the current view
     setView( (View::Mode) Settings::application.current_view );
+
+    Log::Info("%d meshes loaded in %.1f ms.", Mesh::loadingCount(), Mesh::loadingTime());
 }
 
 void Mixer::update()
 {
-    // sort-of garbage collector : just wait for 1 iteration
-    // before deleting the previous session: this way, the sources
-    // had time to end properly
-    if (garbage_.size()>0) {
-        delete garbage_.back();
-        garbage_.pop_back();
-    }
-
 #ifdef THREADED_LOADING
     // if there is a session importer pending
     if (!sessionImporters_.empty()) {
@@ -176,12 +172,12 @@ void Mixer::update()
         }
     }
 
-    // if there is a source candidate for this session
-    if (candidate_sources_.size() > 0) {
-        // NB: only make the last candidate the current source in Mixing view
-        insertSource(candidate_sources_.front(), candidate_sources_.size() > 1 ? View::INVALID : View::MIXING);
-        candidate_sources_.pop_front();
-    }
+    // execute deferred tasks (insertion of sources, deletion of sessions)
+    TaskQueue::manager().run();
+
+    // create frames and handles of new sources displayed in the current view
+    for (auto it = session_->begin(); it != session_->end(); it++)
+        (*it)->decorate( current_view_->mode() );
 
     // compute dt
     if (update_time_ == GST_CLOCK_TIME_NONE)
@@ -355,6 +351,14 @@ void Mixer::addSource(Source *s)
 {
     if (s != nullptr) {
         candidate_sources_.push_back(s);
+        // insert the candidates in order, in the main thread tasks
+        TaskQueue::manager().push( [this]() {
+            if (candidate_sources_.size() > 0) {
+                // NB: only make the last candidate the current source in Mixing view
+                insertSource(candidate_sources_.front(), candidate_sources_.size() > 1 ? View::INVALID : View::MIXING);
+                candidate_sources_.pop_front();
+            }
+        });
     }
 }
 
@@ -706,6 +710,10 @@ void Mixer::setView(View::Mode m)
         break;
     }
 
+    // create frames and handles of sources on first display of the view
+    for (auto it = session_->begin(); it != session_->end(); it++)
+        (*it)->decorate( current_view_->mode() );
+
     // need to deeply update view to apply eventual changes
     View::need_deep_update_ = true;
 
@@ -756,7 +764,7 @@ void Mixer::load(const std::string& filename)
     if (sessionLoaders_.empty()) {
         // Start async thread for loading the session
         // Will be obtained in the future in update()
-        sessionLoaders_.emplace_back( std::async(std::launch::async, Session::load, filename) );
+        sessionLoaders_.emplace_back( std::async(std::launch::async, Session::load, filename, 0) );
     }
 #else
     set( Session::load(filename) );
@@ -794,7 +802,7 @@ void Mixer::import(const std::string& filename)
     if (sessionImporters_.empty()) {
         // Start async thread for loading the session
         // Will be obtained in the future in update()
-        sessionImporters_.emplace_back( std::async(std::launch::async, Session::load, filename) );
+        sessionImporters_.emplace_back( std::async(std::launch::async, Session::load, filename, 0) );
     }
 #else
     merge( Session::load(filename) );
@@ -860,7 +868,7 @@ void Mixer::swap()
     update_time_ = GST_CLOCK_TIME_NONE;
 
     // delete back (former front session)
-    garbage_.push_back(back_session_);
+    deleteSession(back_session_);
     back_session_ = nullptr;
 
     // reset History manager
@@ -870,6 +878,20 @@ void Mixer::swap()
     Log::Notify("Session %s loaded. %d source(s) created.", session_->filename().c_str(), session_->numSource());
 }
 
+void Mixer::deleteSession(Session *s)
+{
+    // sort-of garbage collector : wait for 1 iteration before deleting
+    // the sources of the session (this way, they had time to end properly),
+    // and delete them one by one in the main thread tasks
+    TaskQueue::manager().push( [s]() {
+        for (auto it = s->begin(); it != s->end(); it++) {
+            Source *source = *it;
+            TaskQueue::manager().push( [s, source]() { s->deleteSource(source); } );
+        }
+        TaskQueue::manager().push( [s]() { delete s; } );
+    });
+}
+
 void Mixer::close()
 {
     if (Settings::application.smooth_transition)
@@ -892,7 +914,7 @@ void Mixer::clear()
 {
     // delete previous back session if needed
     if (back_session_)
-        garbage_.push_back(back_session_);
+        deleteSession(back_session_);
 
     // create empty session
     back_session_ = new Session;
@@ -912,7 +934,7 @@ void Mixer::set(Session *s)
 
     // delete previous back session if needed
     if (back_session_)
-        garbage_.push_back(back_session_);
+        deleteSession(back_session_);
 
     // set to new given session
     back_session_ = s;
@@ -98,9 +98,9 @@ protected:
 
     Session *session_;
     Session *back_session_;
-    std::list<Session *> garbage_;
     bool sessionSwapRequested_;
     void swap();
+    void deleteSession(Session *s);
 
     SourceList candidate_sources_;
     SourceList stash_;
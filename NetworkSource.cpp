@@ -238,6 +238,10 @@ void NetworkStream::update()
                 }
                 parameter = "\"" + parameter + "\"";
             }
+            // for SRT, the parameter is the address of the streamer to call
+            else if (config_.protocol == NetworkToolkit::SRT_H264) {
+                parameter = streamer_.address + ":" + parameter;
+            }
 
             // general case : create pipeline and open
             if (!failed_) {
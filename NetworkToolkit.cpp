@@ -3,6 +3,7 @@
 
 #include <string.h>
 #include <unistd.h>
+#include <poll.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -54,6 +55,12 @@
  * gst-launch-1.0 udpsrc port=5000 caps = "application/x-rtp, media=(string)video, clock-rate=(int)90000, encoding-name=(string)RAW, sampling=(string)RGBA, depth=(string)8, width=(string)1920, height=(string)1080, colorimetry=(string)SMPTE240M, payload=(int)96, ssrc=(uint)2272750581, timestamp-offset=(uint)1699493959, seqnum-offset=(uint)14107, a-framerate=(string)30" ! rtpvrawdepay ! videoconvert ! autovideosink
  *
  *
+ *       SRT H264 : reliable (retransmission of lost packets within latency window)
+ * SND (listener)
+ * gst-launch-1.0 videotestsrc is-live=true ! x264enc tune="zerolatency" key-int-max=15 ! mpegtsmux alignment=7 ! srtsink uri=srt://:5000?mode=listener wait-for-connection=false
+ * RCV (caller)
+ * gst-launch-1.0 srtsrc uri=srt://127.0.0.1:5000 latency=125 ! tsdemux ! h264parse ! avdec_h264 ! autovideosink
+ *
  *       SHM RAW RGB
  * SND
  * gst-launch-1.0 videotestsrc is-live=true ! video/x-raw, format=RGB, framerate=30/1 ! shmsink socket-path=/tmp/blah
@@ -67,7 +74,8 @@ const char* NetworkToolkit::protocol_name[NetworkToolkit::DEFAULT] = {
     "RTP JPEG Stream",
     "RTP H264 Stream",
     "RTP JPEG Broadcast",
-    "RTP H264 Broadcast"
+    "RTP H264 Broadcast",
+    "SRT H264 Stream"
 };
 
 const std::vector<std::string> NetworkToolkit::protocol_send_pipeline {
@@ -76,7 +84,8 @@ const std::vector<std::string> NetworkToolkit::protocol_send_pipeline {
     "video/x-raw, format=I420, framerate=30/1 ! queue max-size-buffers=10 ! jpegenc ! rtpjpegpay ! udpsink name=sink",
     "video/x-raw, format=I420, framerate=30/1 ! queue max-size-buffers=10 ! x264enc tune=\"zerolatency\" threads=2 ! rtph264pay ! udpsink name=sink",
     "video/x-raw, format=I420, framerate=30/1 ! queue max-size-buffers=3 ! jpegenc ! rtpjpegpay ! rtpstreampay ! tcpserversink name=sink",
-    "video/x-raw, format=I420, framerate=30/1 ! queue max-size-buffers=3 ! x264enc tune=\"zerolatency\" threads=2 ! rtph264pay ! rtpstreampay ! tcpserversink name=sink"
+    "video/x-raw, format=I420, framerate=30/1 ! queue max-size-buffers=3 ! x264enc tune=\"zerolatency\" threads=2 ! rtph264pay ! rtpstreampay ! tcpserversink name=sink",
+    "video/x-raw, format=I420, framerate=30/1 ! queue max-size-buffers=3 ! x264enc tune=\"zerolatency\" threads=2 key-int-max=15 ! mpegtsmux alignment=7 ! srtsink wait-for-connection=false name=sink"
 };
 
 const std::vector<std::string> NetworkToolkit::protocol_receive_pipeline {
@@ -85,7 +94,19 @@ const std::vector<std::string> NetworkToolkit::protocol_receive_pipeline {
     "udpsrc buffer-size=200000 port=XXXX ! application/x-rtp,encoding-name=JPEG,payload=26,clock-rate=90000 ! queue max-size-buffers=10 ! rtpjpegdepay ! jpegdec",
     "udpsrc buffer-size=200000 port=XXXX ! application/x-rtp,encoding-name=H264,payload=96,clock-rate=90000 ! queue ! rtph264depay ! avdec_h264",
     "tcpclientsrc timeout=1 port=XXXX ! queue max-size-buffers=30 ! application/x-rtp-stream,media=video,encoding-name=JPEG,payload=26,clock-rate=90000 ! rtpstreamdepay ! rtpjpegdepay ! jpegdec",
-    "tcpclientsrc timeout=1 port=XXXX ! queue max-size-buffers=30 ! application/x-rtp-stream,media=video,encoding-name=H264,payload=96,clock-rate=90000 ! rtpstreamdepay ! rtph264depay ! avdec_h264"
+    "tcpclientsrc timeout=1 port=XXXX ! queue max-size-buffers=30 ! application/x-rtp-stream,media=video,encoding-name=H264,payload=96,clock-rate=90000 ! rtpstreamdepay ! rtph264depay ! avdec_h264",
+    "srtsrc uri=srt://XXXX latency=125 ! queue max-size-buffers=30 ! tsdemux ! h264parse ! avdec_h264"
+};
+
+// space separated list of gstreamer elements needed by each protocol (send & receive)
+const std::vector<std::string> NetworkToolkit::protocol_elements {
+
+    "shmsink shmsrc",
+    "jpegenc rtpjpegpay udpsink udpsrc rtpjpegdepay jpegdec",
+    "x264enc rtph264pay udpsink udpsrc rtph264depay avdec_h264",
+    "jpegenc rtpjpegpay rtpstreampay tcpserversink tcpclientsrc rtpstreamdepay rtpjpegdepay jpegdec",
+    "x264enc rtph264pay rtpstreampay tcpserversink tcpclientsrc rtpstreamdepay rtph264depay avdec_h264",
+    "x264enc mpegtsmux srtsink srtsrc tsdemux h264parse avdec_h264"
 };
 
 bool initialized_ = false;
@@ -206,3 +227,120 @@ std::string NetworkToolkit::hostname()
 
     return std::string(hostname);
 }
+
+
+NetworkToolkit::LossyRelay::LossyRelay(int listen_port, int target_port) :
+    listen_port_(listen_port), target_port_(target_port), socket_(-1)
+{
+    running_ = false;
+    loss_ = 0.f;
+    bytes_ = 0;
+    packets_ = 0;
+    dropped_ = 0;
+}
+
+NetworkToolkit::LossyRelay::~LossyRelay()
+{
+    stop();
+}
+
+bool NetworkToolkit::LossyRelay::start()
+{
+    if (running_)
+        return true;
+
+    // udp socket listening on loopback
+    socket_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (socket_ < 0)
+        return false;
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(listen_port_);
+    if ( bind(socket_, (struct sockaddr *) &addr, sizeof addr) < 0 ) {
+        close(socket_);
+        socket_ = -1;
+        return false;
+    }
+
+    // reset statistics
+    bytes_ = 0;
+    packets_ = 0;
+    dropped_ = 0;
+
+    running_ = true;
+    thread_ = std::thread(relay_, this);
+    return true;
+}
+
+void NetworkToolkit::LossyRelay::stop()
+{
+    if (!running_)
+        return;
+
+    // relay thread wakes up regularly to check for termination
+    running_ = false;
+    if (thread_.joinable())
+        thread_.join();
+
+    close(socket_);
+    socket_ = -1;
+}
+
+void NetworkToolkit::LossyRelay::relay_(LossyRelay *r)
+{
+    char buffer[65536];
+
+    struct sockaddr_in target;
+    memset(&target, 0, sizeof target);
+    target.sin_family = AF_INET;
+    target.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    target.sin_port = htons(r->target_port_);
+
+    // the peer is whoever sent to the relay and is not the target
+    struct sockaddr_in peer;
+    memset(&peer, 0, sizeof peer);
+    bool has_peer = false;
+
+    struct pollfd pfd;
+    pfd.fd = r->socket_;
+    pfd.events = POLLIN;
+
+    while (r->running_) {
+
+        // wait at most 100 ms to check running_ again
+        if ( poll(&pfd, 1, 100) < 1 )
+            continue;
+
+        struct sockaddr_in from;
+        socklen_t fromlen = sizeof from;
+        ssize_t len = recvfrom(r->socket_, buffer, sizeof buffer, 0, (struct sockaddr *) &from, &fromlen);
+        if (len < 1)
+            continue;
+
+        bool from_target = from.sin_port == target.sin_port;
+        if (!from_target) {
+            peer = from;
+            has_peer = true;
+        }
+
+        // emulate packet loss
+        if ( float(rand()) / float(RAND_MAX) < r->loss_ ) {
+            r->dropped_++;
+            continue;
+        }
+
+        // forward to the other end
+        if (from_target) {
+            if (has_peer)
+                sendto(r->socket_, buffer, len, 0, (struct sockaddr *) &peer, sizeof peer);
+        }
+        else
+            sendto(r->socket_, buffer, len, 0, (struct sockaddr *) &target, sizeof target);
+
+        r->packets_++;
+        r->bytes_ += len;
+    }
+}
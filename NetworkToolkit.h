@@ -3,6 +3,8 @@
 
 #include <string>
 #include <vector>
+#include <atomic>
+#include <thread>
 
 #define OSC_PREFIX "/vimix"
 #define OSC_PING "/ping"
@@ -18,6 +20,7 @@
 #define STREAM_REQUEST_PORT 71510
 #define OSC_DIALOG_PORT 71010
 #define IP_MTU_SIZE 1536
+#define LOOPBACK_TEST_PORT 51400
 
 namespace NetworkToolkit
 {
@@ -28,6 +31,7 @@ typedef enum {
     UDP_H264,
     TCP_JPEG,
     TCP_H264,
+    SRT_H264,
     DEFAULT
 } Protocol;
 
@@ -67,6 +71,44 @@ struct StreamConfig {
 extern const char* protocol_name[DEFAULT];
 extern const std::vector<std::string> protocol_send_pipeline;
 extern const std::vector<std::string> protocol_receive_pipeline;
+extern const std::vector<std::string> protocol_elements;
+
+/**
+ * @brief The LossyRelay forwards UDP datagrams received on a local port
+ * to another local port (and replies back to the sender), dropping a
+ * given ratio of packets in both directions.
+ * This emulates a lossy network on the loopback interface, e.g. to test
+ * streaming protocols without any remote machine.
+ */
+class LossyRelay
+{
+public:
+    LossyRelay(int listen_port, int target_port);
+    ~LossyRelay();
+
+    bool start();
+    void stop();
+
+    inline void setLoss(float l) { loss_ = l; }
+    inline float loss() const { return loss_; }
+
+    inline uint64_t bytes() const { return bytes_; }
+    inline uint64_t packets() const { return packets_; }
+    inline uint64_t dropped() const { return dropped_; }
+
+private:
+    int listen_port_;
+    int target_port_;
+    int socket_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+    std::atomic<float> loss_;
+    std::atomic<uint64_t> bytes_;
+    std::atomic<uint64_t> packets_;
+    std::atomic<uint64_t> dropped_;
+
+    static void relay_(LossyRelay *r);
+};
 
 std::string hostname();
 std::vector<std::string> host_ips();
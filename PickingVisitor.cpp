@@ -4,6 +4,7 @@
 #include "Decorations.h"
 
 #include "GlmToolkit.h"
+#include <algorithm>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_access.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -11,19 +12,26 @@
 #include <glm/gtx/vector_angle.hpp>
 
 
-PickingVisitor::PickingVisitor(glm::vec3 coordinates, bool force) : Visitor(), force_(force)
+PickingVisitor::PickingVisitor(glm::vec3 coordinates, bool force) : Visitor(), force_(force), culled_group_(nullptr)
 {
     modelview_ = glm::mat4(1.f);
     points_.push_back( coordinates );
 }
 
-PickingVisitor::PickingVisitor(glm::vec3 selectionstart, glm::vec3 selection_end, bool force) : Visitor(), force_(force)
+PickingVisitor::PickingVisitor(glm::vec3 selectionstart, glm::vec3 selection_end, bool force) : Visitor(), force_(force), culled_group_(nullptr)
 {
     modelview_ = glm::mat4(1.f);
     points_.push_back( selectionstart );
     points_.push_back( selection_end );
 }
 
+void PickingVisitor::setCandidates(Group *group, std::vector<Node *> candidates)
+{
+    culled_group_ = group;
+    candidates_ = candidates;
+    std::sort(candidates_.begin(), candidates_.end());
+}
+
 void PickingVisitor::visit(Node &n)
 {
     // use the transform modified during update
@@ -35,8 +43,12 @@ void PickingVisitor::visit(Group &n)
     if (!n.visible_ && !force_)
         return;
 
+    bool culled = ( &n == culled_group_ );
+
     glm::mat4 mv = modelview_;
     for (NodeSet::iterator node = n.begin(); node != n.end(); node++) {
+        if ( culled && !std::binary_search(candidates_.begin(), candidates_.end(), *node) )
+            continue;
         if ( (*node)->visible_ || force_)
             (*node)->accept(*this);
         modelview_ = mv;
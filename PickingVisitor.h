@@ -22,6 +22,8 @@ class PickingVisitor: public Visitor
     glm::mat4 modelview_;
     std::vector< std::pair<Node *, glm::vec2> > nodes_;
     bool force_;
+    Group *culled_group_;
+    std::vector<Node *> candidates_;
 
 public:
 
@@ -33,6 +35,10 @@ public:
     std::vector< std::pair<Node *, glm::vec2> >::const_reverse_iterator rbegin() { return nodes_.rbegin(); }
     std::vector< std::pair<Node *, glm::vec2> >::const_reverse_iterator rend()   { return nodes_.rend(); }
 
+    // visit only the given children of the group
+    // (e.g. found in a spatial index, others cannot be picked)
+    void setCandidates(Group *group, std::vector<Node *> candidates);
+
     // Elements of Scene
     void visit(Scene& n) override;
     void visit(Node& n) override;
@@ -108,13 +108,20 @@ ImageSurface::ImageSurface(const std::string& path, Shader *s) : Surface(s), res
 
 }
 
+ImageSurface::~ImageSurface()
+{
+    // give back the texture of the image
+    if ( initialized() && !resource_.empty() )
+        Resource::releaseTexture(resource_);
+}
+
 void ImageSurface::init()
 {
     Surface::init();
 
     // load image if specified (should always be the case)
     if ( !resource_.empty()) {
-        textureindex_ = Resource::getTextureImage(resource_);
+        textureindex_ = Resource::getTextureImageAsync(resource_);
     }
 }
 
@@ -47,6 +47,7 @@ class ImageSurface : public Surface {
 
 public:
     ImageSurface(const std::string& path, Shader *s = new ImageShader);
+    ~ImageSurface();
 
     void init () override;
     void accept (Visitor& v) override;
@@ -99,6 +100,7 @@ public:
     void accept (Visitor& v) override;
 
     inline FrameBuffer *getFrameBuffer() const { return frame_buffer_; }
+    inline void setFrameBuffer(FrameBuffer *fb) { frame_buffer_ = fb; }
 
 protected:
     FrameBuffer *frame_buffer_;
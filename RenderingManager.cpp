@@ -42,6 +42,8 @@
 #include "defines.h"
 #include "Log.h"
 #include "Resource.h"
+#include "GpuPool.h"
+#include "InstanceBatch.h"
 #include "Settings.h"
 #include "Primitives.h"
 #include "Mixer.h"
@@ -113,6 +115,8 @@ Rendering::Rendering()
 {
 //    main_window_ = nullptr;
     request_screenshot_ = false;
+    background_ = nullptr;
+    background_stop_ = false;
 }
 
 bool Rendering::init()
@@ -186,9 +190,55 @@ bool Rendering::init()
     glfwSetKeyCallback( output_.window(), WindowEscapeFullscreen);
     glfwSetMouseButtonCallback( output_.window(), WindowToggleFullscreen);
 
+    //
+    // background context
+    //
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    background_ = glfwCreateWindow(1, 1, "", NULL, main_.window());
+    if (background_)
+        background_thread_ = std::thread(&Rendering::background, this);
+    else
+        Log::Info("No background OpenGL context; tasks will run in main thread.");
+
     return true;
 }
 
+void Rendering::background()
+{
+    glfwMakeContextCurrent(background_);
+
+    std::unique_lock<std::mutex> lock(background_lock_);
+    while (!background_stop_) {
+        // wait for a task
+        if (background_tasks_.empty()) {
+            background_condition_.wait(lock);
+            continue;
+        }
+        BackgroundTask task = background_tasks_.front();
+        background_tasks_.pop_front();
+
+        // run it unlocked
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+
+    glfwMakeContextCurrent(NULL);
+}
+
+void Rendering::pushBackgroundTask(BackgroundTask task)
+{
+    // no background context : run in current context
+    if (!background_thread_.joinable()) {
+        task();
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(background_lock_);
+    background_tasks_.push_back(task);
+    background_condition_.notify_one();
+}
+
 
 void Rendering::show()
 {
@@ -223,6 +273,9 @@ void Rendering::draw()
     // operate on main window context
     main_.makeCurrent();
 
+    // upload images loaded in background
+    Resource::update();
+
     // User Interface step 1
     UserInterface::manager().NewFrame();
 
@@ -250,6 +303,10 @@ void Rendering::draw()
     glfwSwapBuffers(main_.window());
     glfwSwapBuffers(output_.window());
 
+    // count calls to OpenGL made by shaders at every frame
+    ShadingProgram::endFrame();
+    InstanceBatch::manager().endFrame();
+
     // Poll and handle events (inputs, window resize, etc.)
     // You can read the io.WantCaptureMouse, io.WantCaptureKeyboard flags to tell if dear imgui wants to use your inputs.
     // - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application.
@@ -269,6 +326,22 @@ void Rendering::draw()
 
 void Rendering::terminate()
 {
+    // free recycled textures and buffers
+    GpuPool::manager().clear();
+
+    // stop background thread (pending tasks are dropped)
+    if (background_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(background_lock_);
+            background_stop_ = true;
+            background_tasks_.clear();
+            background_condition_.notify_one();
+        }
+        background_thread_.join();
+    }
+    if (background_)
+        glfwDestroyWindow(background_);
+
     // close window
     glfwDestroyWindow(output_.window());
     glfwDestroyWindow(main_.window());
@@ -4,6 +4,10 @@
 #include <string>
 #include <list>
 #include <map>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <condition_variable>
 
 #include <gst/gl/gl.h>
 #include <glm/glm.hpp> 
@@ -122,6 +126,13 @@ public:
     void pushFrontDrawCallback(RenderingCallback function);
     void pushBackDrawCallback(RenderingCallback function);
 
+    // add function to call in a background thread, with an OpenGL context
+    // shared with the main window (e.g. to compile shaders without blocking).
+    // Tasks shall call glFinish() before telling the main thread that their
+    // OpenGL objects are ready. Run immediately if there is no such context.
+    typedef std::function<void(void)> BackgroundTask;
+    void pushBackgroundTask(BackgroundTask task);
+
     // push and pop rendering attributes
     void pushAttrib(RenderingAttrib ra);
     void popAttrib();
@@ -156,6 +167,15 @@ private:
     RenderingWindow main_;
     RenderingWindow output_;
 
+    // hidden window giving a shared OpenGL context to the background thread
+    GLFWwindow *background_;
+    std::thread background_thread_;
+    std::mutex background_lock_;
+    std::condition_variable background_condition_;
+    std::list<BackgroundTask> background_tasks_;
+    bool background_stop_;
+    void background();
+
     // file drop callback
     static void FileDropped(GLFWwindow* main_window_, int path_count, const char* paths[]);
 
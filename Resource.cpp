@@ -1,11 +1,22 @@
 #include "defines.h"
 #include "Resource.h"
+#include "GpuPool.h"
+#include "Settings.h"
+#include "SystemToolkit.h"
 #include "Log.h"
 
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <cstring>
+#include <list>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <string_view>
 
 //  Desktop OpenGL function loader
 #include <glad/glad.h>
@@ -16,13 +27,58 @@
 // standalone image loader
 #include "stb_image.h"
 
+// standalone DXT compressor
+#define STB_DXT_IMPLEMENTATION
+#include "stb_dxt.h"
+
 // CMake Ressource Compiler
 #include <cmrc/cmrc.hpp>
 CMRC_DECLARE(vmix);
 
 
-std::map<std::string, uint> textureIndex;
-std::map<std::string, float> textureAspectRatio;
+// textures of resources, with count of users
+struct CachedTexture {
+    uint texture;
+    float aspect_ratio;
+    size_t memory;
+    int references;
+};
+std::map<std::string, CachedTexture> textureCache;
+// textures not used anymore, most recently released first
+std::list<std::string> textureUnused;
+
+static bool acquireCachedTexture(const std::string& path, uint *texture, float *aspect_ratio)
+{
+    auto it = textureCache.find(path);
+    if ( it == textureCache.end() )
+        return false;
+
+    // used again
+    if ( it->second.references < 1 )
+        textureUnused.remove(path);
+    it->second.references++;
+
+    *texture = it->second.texture;
+    if (aspect_ratio) *aspect_ratio = it->second.aspect_ratio;
+    return true;
+}
+
+static void addCachedTexture(const std::string& path, uint texture, float aspect_ratio, size_t memory)
+{
+    CachedTexture t;
+    t.texture = texture;
+    t.aspect_ratio = aspect_ratio;
+    t.memory = memory;
+    t.references = 1;
+    textureCache[path] = t;
+}
+
+// number of threads decoding images for getTextureImageAsync
+#define RESOURCE_DECODING_THREADS 2
+// maximum amount of pixels copied for upload at each update (bytes)
+#define RESOURCE_UPLOAD_PER_FRAME 4194304
+// minimum number of pixels of images to compress
+#define RESOURCE_COMPRESSION_MIN_PIXELS 262144
 
 // opengl texture
 uint Resource::getTextureBlack()
@@ -88,6 +144,12 @@ uint Resource::getTextureTransparent()
     return tex_index_transparent;
 }
 
+bool Resource::hasPath(const std::string& path)
+{
+    auto fs = cmrc::vmix::get_filesystem();
+    return fs.is_file(path);
+}
+
 const char *Resource::getData(const std::string& path, size_t* out_file_size){
 
     auto  fs = cmrc::vmix::get_filesystem();
@@ -134,10 +196,9 @@ uint Resource::getTextureDDS(const std::string& path, float *aspect_ratio)
 {
 	GLuint textureID = 0;
 
-    if (textureIndex.count(path) > 0){
-        if (aspect_ratio) *aspect_ratio = textureAspectRatio[path];
-        return textureIndex[path];
-    }
+    // return previously openned resource if already openned before
+    if ( acquireCachedTexture(path, &textureID, aspect_ratio) )
+        return textureID;
 
     // Get the pointer
     size_t size = 0;
@@ -224,8 +285,7 @@ uint Resource::getTextureDDS(const std::string& path, float *aspect_ratio)
 	}
 
     // remember to avoid openning the same resource twice
-    textureIndex[path] = textureID;
-    textureAspectRatio[path] = ar;
+    addCachedTexture(path, textureID, ar, offset);
 
     // return values
     if (aspect_ratio) *aspect_ratio = ar;
@@ -242,10 +302,8 @@ uint Resource::getTextureImage(const std::string& path, float *aspect_ratio)
 	GLuint textureID = 0;
 
     // return previously openned resource if already openned before
-    if (textureIndex.count(path) > 0) {
-        if (aspect_ratio) *aspect_ratio = textureAspectRatio[path];
-		return textureIndex[path];
-    }
+    if ( acquireCachedTexture(path, &textureID, aspect_ratio) )
+        return textureID;
 
     float ar = 1.0;
  	int w, h, n;
@@ -284,14 +342,350 @@ uint Resource::getTextureImage(const std::string& path, float *aspect_ratio)
 	stbi_image_free(img);
 
     // remember to avoid openning the same resource twice
-	textureIndex[path] = textureID;
-    textureAspectRatio[path] = ar;
+    addCachedTexture(path, textureID, ar, (size_t) w * (size_t) h * 4);
 
     // return values
     if (aspect_ratio) *aspect_ratio = ar;
 	return textureID;
 }
 
+// image loaded by getTextureImageAsync
+struct ImageLoading {
+    std::string path;
+    uint texture;
+    // decoded in background
+    std::atomic<bool> decoded;
+    unsigned char *pixels;
+    int width, height;
+    std::string error;
+    // compressed in background (if cache folder given)
+    std::string cache;
+    uint format;
+    std::vector<unsigned char> compressed;
+    // copied to pixel buffer and uploaded in update()
+    uint pbo;
+    size_t copied;
+
+    ImageLoading() : texture(0), decoded(false), pixels(nullptr), width(0), height(0),
+        format(0), pbo(0), copied(0) {}
+
+    inline const unsigned char *data() const { return format ? compressed.data() : pixels; }
+    inline size_t size() const { return format ? compressed.size() : (size_t) width * (size_t) height * 4; }
+    ~ImageLoading() {
+        if (pixels)
+            stbi_image_free(pixels);
+    }
+};
+
+// header of compressed image files
+#define COMPRESSED_MAGIC 0x56585443 // 'VXTC'
+struct CompressedHeader {
+    uint32_t magic;
+    uint32_t format;
+    int32_t width;
+    int32_t height;
+};
+
+static std::string compressedFilename(ImageLoading *image, const char *data, size_t size)
+{
+    // one file per content of image
+    size_t h = std::hash<std::string_view>{}(std::string_view(data, size));
+    return SystemToolkit::full_filename(image->cache, std::to_string(h) + ".dxt");
+}
+
+static bool loadCompressed(ImageLoading *image, const std::string &filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    CompressedHeader header = { 0, 0, 0, 0 };
+    file.read((char *) &header, sizeof(CompressedHeader));
+    std::vector<unsigned char> blocks( (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>() );
+
+    // validate size of blocks
+    size_t blocksize = (header.format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? 16 : 8;
+    if ( header.magic != COMPRESSED_MAGIC || header.width < 1 || header.height < 1
+         || blocks.size() != (size_t) ((header.width+3)/4) * (size_t) ((header.height+3)/4) * blocksize )
+        return false;
+
+    image->format = header.format;
+    image->width = header.width;
+    image->height = header.height;
+    image->compressed.swap(blocks);
+    return true;
+}
+
+static void compress(ImageLoading *image, const std::string &filename)
+{
+    // DXT1 for opaque images, DXT5 otherwise
+    size_t n = (size_t) image->width * (size_t) image->height;
+    bool alpha = false;
+    for (size_t i = 0; i < n && !alpha; ++i)
+        alpha = image->pixels[i * 4 + 3] < 255;
+    size_t blocksize = alpha ? 16 : 8;
+
+    // compress blocks of 4x4 pixels (repeat last pixels on borders)
+    int bw = (image->width + 3) / 4;
+    int bh = (image->height + 3) / 4;
+    image->compressed.resize( (size_t) bw * (size_t) bh * blocksize );
+    unsigned char block[64];
+    for (int by = 0; by < bh; ++by) {
+        for (int bx = 0; bx < bw; ++bx) {
+            for (int j = 0; j < 4; ++j) {
+                int y = MINI(by * 4 + j, image->height - 1);
+                for (int i = 0; i < 4; ++i) {
+                    int x = MINI(bx * 4 + i, image->width - 1);
+                    memcpy(block + (j * 4 + i) * 4, image->pixels + ((size_t) y * image->width + x) * 4, 4);
+                }
+            }
+            stb_compress_dxt_block(image->compressed.data() + ((size_t) by * bw + bx) * blocksize,
+                                   block, alpha ? 1 : 0, STB_DXT_HIGHQUAL);
+        }
+    }
+    image->format = alpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    stbi_image_free(image->pixels);
+    image->pixels = nullptr;
+
+    // keep on disk
+    if ( !SystemToolkit::file_exists(image->cache) )
+        SystemToolkit::create_directory(image->cache);
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (file.is_open()) {
+        CompressedHeader header = { COMPRESSED_MAGIC, image->format, image->width, image->height };
+        file.write((const char *) &header, sizeof(CompressedHeader));
+        file.write((const char *) image->compressed.data(), image->compressed.size());
+    }
+}
+
+// threads decoding images in background
+class ImageDecoding
+{
+    std::mutex lock_;
+    std::condition_variable condition_;
+    std::deque< std::shared_ptr<ImageLoading> > queue_;
+
+    void decode() {
+        std::unique_lock<std::mutex> lock(lock_);
+        while (true) {
+            if (queue_.empty()) {
+                condition_.wait(lock);
+                continue;
+            }
+            std::shared_ptr<ImageLoading> image = queue_.front();
+            queue_.pop_front();
+
+            // decode unlocked
+            lock.unlock();
+            size_t size = 0;
+            const char *fp = Resource::getData(image->path, &size);
+
+            // image compressed previously
+            std::string compressedfile;
+            if ( size > 0 && !image->cache.empty() ) {
+                compressedfile = compressedFilename(image.get(), fp, size);
+                if ( loadCompressed(image.get(), compressedfile) ) {
+                    image->decoded = true;
+                    lock.lock();
+                    continue;
+                }
+            }
+
+            int n = 0;
+            if ( size > 0 )
+                image->pixels = stbi_load_from_memory(reinterpret_cast<const unsigned char *>(fp), size,
+                                                      &image->width, &image->height, &n, 4);
+            if ( size == 0 )
+                image->error = "empty?";
+            else if ( image->pixels == nullptr )
+                image->error = stbi_failure_reason();
+            else if ( image->height == 0 )
+                image->error = "invalid image";
+            // compress large images
+            else if ( !compressedfile.empty()
+                      && (size_t) image->width * (size_t) image->height >= RESOURCE_COMPRESSION_MIN_PIXELS )
+                compress(image.get(), compressedfile);
+            image->decoded = true;
+            lock.lock();
+        }
+    }
+
+public:
+    ImageDecoding() {
+        for (int i = 0; i < RESOURCE_DECODING_THREADS; ++i)
+            std::thread(&ImageDecoding::decode, this).detach();
+    }
+
+    void push(std::shared_ptr<ImageLoading> image) {
+        std::lock_guard<std::mutex> lock(lock_);
+        queue_.push_back(image);
+        condition_.notify_one();
+    }
+};
+
+std::list< std::shared_ptr<ImageLoading> > imageLoading;
+
+uint Resource::getTextureImageAsync(const std::string& path, float *aspect_ratio)
+{
+    std::string ext = path.substr(path.find_last_of(".") + 1);
+    if (ext=="dds")
+        return getTextureDDS(path, aspect_ratio);
+
+    // return previously openned (or loading) resource
+    GLuint textureID = 0;
+    if ( acquireCachedTexture(path, &textureID, aspect_ratio) )
+        return textureID;
+
+    // transparent texture until loaded (not immutable to be allocated later)
+    unsigned char clearColor[4] = {0, 0, 0, 0};
+    glGenTextures(1, &textureID);
+    glBindTexture( GL_TEXTURE_2D, textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, clearColor);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // decode in background (threads never stop: never deleted)
+    static ImageDecoding *decoding = new ImageDecoding;
+    std::shared_ptr<ImageLoading> image = std::make_shared<ImageLoading>();
+    image->path = path;
+    image->texture = textureID;
+    if ( Settings::application.render.texture_compression && GLAD_GL_EXT_texture_compression_s3tc )
+        image->cache = SystemToolkit::full_filename(SystemToolkit::settings_path(), "textures");
+    imageLoading.push_back(image);
+    decoding->push(image);
+
+    // remember to avoid openning the same resource twice
+    addCachedTexture(path, textureID, 1.f, 4);
+
+    // return values
+    if (aspect_ratio) *aspect_ratio = 1.f;
+    return textureID;
+}
+
+void Resource::releaseTexture(const std::string& path)
+{
+    auto it = textureCache.find(path);
+    if ( it == textureCache.end() || it->second.references < 1 )
+        return;
+
+    // not used anymore: will be deleted in update() if over budget
+    it->second.references--;
+    if ( it->second.references < 1 )
+        textureUnused.push_front(path);
+}
+
+std::list<Resource::TextureInfo> Resource::listTextures()
+{
+    std::list<TextureInfo> list;
+    for (auto it = textureCache.begin(); it != textureCache.end(); ++it) {
+        TextureInfo info;
+        info.path = it->first;
+        info.memory = it->second.memory;
+        info.references = it->second.references;
+        list.push_back(info);
+    }
+    return list;
+}
+
+static void trimTextureCache()
+{
+    size_t budget = (size_t) MAXI(Settings::application.render.texture_cache, 0) * 1048576;
+
+    size_t unused = 0;
+    for (auto it = textureUnused.begin(); it != textureUnused.end(); ++it)
+        unused += textureCache[*it].memory;
+
+    // delete least recently released textures
+    while ( !textureUnused.empty() && unused > budget ) {
+        auto t = textureCache.find(textureUnused.back());
+        if ( t != textureCache.end() ) {
+            // stop loading
+            for (auto i = imageLoading.begin(); i != imageLoading.end(); ) {
+                if ( (*i)->texture == t->second.texture ) {
+                    if ( (*i)->pbo )
+                        GpuPool::manager().releaseBuffer( (*i)->pbo );
+                    i = imageLoading.erase(i);
+                }
+                else
+                    ++i;
+            }
+            glDeleteTextures(1, &t->second.texture);
+            unused -= t->second.memory;
+            textureCache.erase(t);
+        }
+        textureUnused.pop_back();
+    }
+}
+
+void Resource::update()
+{
+    // free unused textures if needed
+    if ( !textureUnused.empty() )
+        trimTextureCache();
+
+    size_t budget = RESOURCE_UPLOAD_PER_FRAME;
+
+    for (auto it = imageLoading.begin(); it != imageLoading.end() && budget > 0; ) {
+
+        std::shared_ptr<ImageLoading> image = *it;
+
+        // not decoded yet
+        if ( !image->decoded ) {
+            ++it;
+            continue;
+        }
+
+        // failed to decode: keep transparent texture
+        if ( !image->error.empty() ) {
+            Log::Error("Failed to open ressource %s: %s", image->path.c_str(), image->error.c_str() );
+            it = imageLoading.erase(it);
+            continue;
+        }
+
+        // copy a part of the pixels to the pixel buffer
+        size_t size = image->size();
+        if ( image->pbo == 0 )
+            image->pbo = GpuPool::manager().acquireBuffer(size, GL_STREAM_DRAW);
+        size_t chunk = MINI(size - image->copied, budget);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, image->pbo);
+        void *ptr = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, image->copied, chunk,
+                                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        if (ptr) {
+            memcpy(ptr, image->data() + image->copied, chunk);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        image->copied += chunk;
+        budget -= chunk;
+
+        // all copied : allocate and fill texture from pixel buffer
+        if ( image->copied >= size ) {
+            glBindTexture( GL_TEXTURE_2D, image->texture);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            if (image->format)
+                glCompressedTexImage2D(GL_TEXTURE_2D, 0, image->format, image->width, image->height, 0, size, 0);
+            else
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image->width, image->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+            glBindTexture( GL_TEXTURE_2D, 0);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            GpuPool::manager().releaseBuffer(image->pbo);
+
+            auto t = textureCache.find(image->path);
+            if ( t != textureCache.end() ) {
+                t->second.aspect_ratio = static_cast<float>(image->width) / static_cast<float>(image->height);
+                t->second.memory = size;
+            }
+            it = imageLoading.erase(it);
+        }
+        else
+            ++it;
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+}
+
 std::string Resource::listDirectory()
 {
 	// enter icons directory
@@ -315,3 +709,22 @@ std::string Resource::listDirectory()
 
     return ls;
 }
+
+std::list<std::string> Resource::listFiles(const std::string& directory, const std::string& extension)
+{
+    std::list<std::string> files;
+
+    auto fs = cmrc::vmix::get_filesystem();
+    if ( !fs.is_directory(directory) )
+        return files;
+
+    for (auto it = fs.iterate_directory(directory); it != it.end(); it++) {
+        cmrc::directory_entry file = *it;
+        const std::string name = file.filename();
+        if ( file.is_file() && name.size() > extension.size() &&
+             name.compare(name.size() - extension.size(), extension.size(), extension) == 0 )
+            files.push_back(directory + "/" + name);
+    }
+
+    return files;
+}
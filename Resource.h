@@ -3,6 +3,7 @@
 
 #include <string>
 #include <map>
+#include <list>
 #ifdef __APPLE__
 #include <sys/types.h>
 #endif
@@ -22,6 +23,30 @@ namespace Resource
     // Returns the OpenGL generated Texture index
     uint getTextureImage(const std::string& path, float *aspect_ratio = nullptr);
 
+    // Same as getTextureImage, without waiting for the image to be loaded:
+    // the texture is transparent (and aspect ratio 1) until the image is
+    // decoded in a background thread and uploaded in Resource::update().
+    // If enabled in settings, large images are compressed (DXT1 or DXT5),
+    // and kept compressed on disk to be loaded faster next time
+    uint getTextureImageAsync(const std::string& path, float *aspect_ratio = nullptr);
+
+    // Upload the images loaded by getTextureImageAsync (in the OpenGL thread, every frame)
+    void update();
+
+    // Textures given by getTextureDDS, getTextureImage and getTextureImageAsync
+    // are counted for each call: give back a texture when not used anymore.
+    // Unused textures are kept in cache, and deleted in update() if they exceed
+    // Settings::application.render.texture_cache (least recently used first)
+    void releaseTexture(const std::string& path);
+
+    // list of textures loaded from resources
+    struct TextureInfo {
+        std::string path;
+        size_t memory;
+        int references;
+    };
+    std::list<TextureInfo> listTextures();
+
     // Returns the OpenGL generated Texture index for an empty 1x1 black opaque pixel texture
     uint getTextureBlack();
 
@@ -31,12 +56,18 @@ namespace Resource
     // Returns the OpenGL generated Texture index for an empty 1x1 back transparent pixel texture
     uint getTextureTransparent();
 
+    // True if the path is a file in resources
+    bool hasPath(const std::string& path);
+
     // Generic access to pointer to data
     const char *getData(const std::string& path, size_t* out_file_size);
 
     // list files in resource directory
     std::string listDirectory();
 
+    // list paths of files with the given extension in a resource directory
+    std::list<std::string> listFiles(const std::string& directory, const std::string& extension);
+
 }
 
 #endif /* __RSC_MANAGER_H_ */
@@ -7,6 +7,7 @@
 #include "Log.h"
 #include "GlmToolkit.h"
 #include "SessionVisitor.h"
+#include "InstanceBatch.h"
 
 #include <glad/glad.h>
 
@@ -18,7 +19,10 @@
 #include <algorithm>
 
 // Node
-Node::Node() : initialized_(false), visible_(true), refcount_(0)
+uint64_t Node::revision_ = 0;
+uint64_t Node::structure_ = 0;
+
+Node::Node() : initialized_(false), changed_(0), visible_(true), refcount_(0)
 {
     // create unique id
     id_ = GlmToolkit::uniqueId();
@@ -27,6 +31,14 @@ Node::Node() : initialized_(false), visible_(true), refcount_(0)
     scale_ = glm::vec3(1.f);
     rotation_ = glm::vec3(0.f);
     translation_ = glm::vec3(0.f);
+
+    updated_scale_ = scale_;
+    updated_rotation_ = rotation_;
+    updated_translation_ = translation_;
+    updated_visible_ = visible_;
+
+    bbox_cache_.modelview = transform_;
+    bbox_cache_.changed = 0;
 }
 
 Node::~Node ()
@@ -53,6 +65,11 @@ void Node::copyTransform(Node *other)
     scale_ = other->scale_;
     rotation_ = other->rotation_;
     translation_ = other->translation_;
+
+    updated_scale_ = scale_;
+    updated_rotation_ = rotation_;
+    updated_translation_ = translation_;
+    touch();
 }
 
 void Node::update( float dt)
@@ -74,8 +91,20 @@ void Node::update( float dt)
         }
     }
 
-    // update transform matrix from attributes
-    transform_ = GlmToolkit::transform(translation_, rotation_, scale_);
+    // update transform matrix from attributes, only if they changed
+    if ( scale_ != updated_scale_ || rotation_ != updated_rotation_ || translation_ != updated_translation_ ) {
+        transform_ = GlmToolkit::transform(translation_, rotation_, scale_);
+        updated_scale_ = scale_;
+        updated_rotation_ = rotation_;
+        updated_translation_ = translation_;
+        touch();
+    }
+
+    // showing or hiding changes bounding boxes
+    if ( visible_ != updated_visible_ ) {
+        updated_visible_ = visible_;
+        touch();
+    }
 }
 
 void Node::accept(Visitor& v)
@@ -169,6 +198,11 @@ void Primitive::draw(glm::mat4 modelview, glm::mat4 projection)
 
     if ( visible_ ) {
         //
+        // draw pending instances of decorations below
+        //
+        if ( InstanceBatch::manager().active() )
+            InstanceBatch::manager().barrier( bbox_.isNull() ? bbox_ : bbox_.transformed(modelview * transform_) );
+        //
         // prepare and use shader
         //
         if (shader_) {
@@ -209,6 +243,47 @@ void Primitive::replaceShader( Shader *newshader )
     }
 }
 
+//
+// NodeSet
+//
+
+void NodeSet::insert(Node *node)
+{
+    // still sorted if appended after nodes at lower or same depth
+    if ( sorted_ && !nodes_.empty() && z_comparator()(node, nodes_.back()) )
+        sorted_ = false;
+
+    nodes_.push_back(node);
+}
+
+NodeSet::iterator NodeSet::erase(iterator it)
+{
+    return nodes_.erase(it);
+}
+
+NodeSet::iterator NodeSet::begin()
+{
+    if (!sorted_) {
+        std::stable_sort(nodes_.begin(), nodes_.end(), z_comparator());
+        sorted_ = true;
+    }
+    return nodes_.begin();
+}
+
+NodeSet::reverse_iterator NodeSet::rbegin()
+{
+    begin();
+    return nodes_.rbegin();
+}
+
+bool NodeSet::check()
+{
+    if ( sorted_ && !std::is_sorted(nodes_.begin(), nodes_.end(), z_comparator()) )
+        sorted_ = false;
+
+    return !sorted_;
+}
+
 //
 // Group
 //
@@ -220,7 +295,10 @@ Group::~Group()
 
 void Group::clear()
 {
-    for(NodeSet::iterator it = children_.begin(); it != children_.end(); ) {
+    if (!children_.empty())
+        touchStructure();
+
+    for(NodeSet::iterator it = children_.begin(); it != children_.end(); it++) {
         // one less ref to this node
         (*it)->refcount_--;
         // if this group was the only remaining parent
@@ -228,9 +306,9 @@ void Group::clear()
             // delete
             delete (*it);
         }
-        // erase this iterator from the list
-        it = children_.erase(it);
     }
+    // empty the list
+    children_.clear();
 }
 
 void Group::attach(Node *child)
@@ -238,17 +316,16 @@ void Group::attach(Node *child)
     if (child != nullptr) {
         children_.insert(child);
         child->refcount_++;
+        touchStructure();
     }
 }
 
 
 void Group::sort()
 {
-    // reorder list of nodes
-    NodeSet ordered_children;
-    for(auto it = children_.begin(); it != children_.end(); it++)
-        ordered_children.insert(*it);
-    children_.swap(ordered_children);
+    // reorder list of nodes at next traversal
+    children_.invalidate();
+    touchStructure();
 }
 
 void Group::detach(Node *child)
@@ -261,6 +338,7 @@ void Group::detach(Node *child)
             // detatch child from group parent
             children_.erase(it);
             child->refcount_--;
+            touchStructure();
         }
     }
 }
@@ -274,6 +352,15 @@ void Group::update( float dt )
          node != children_.end(); node++) {
         (*node)->update ( dt );
     }
+
+    // depth of children changed: re-order at next traversal
+    if ( children_.check() )
+        touch();
+
+    // changed if any child changed
+    for (NodeSet::iterator node = children_.begin();
+         node != children_.end(); node++)
+        changed_ = MAXI(changed_, (*node)->changed());
 }
 
 void Group::draw(glm::mat4 modelview, glm::mat4 projection)
@@ -336,6 +423,9 @@ Switch::~Switch()
 
 void Switch::clear()
 {
+    if (!children_.empty())
+        touchStructure();
+
     for(std::vector<Node *>::iterator it = children_.begin(); it != children_.end(); ) {
         // one less ref to this node
         (*it)->refcount_--;
@@ -358,8 +448,11 @@ void Switch::update( float dt )
     Node::update(dt);
 
     // update active child node
-    if (!children_.empty())
+    if (!children_.empty()) {
         (children_[active_])->update( dt );
+        // changed if active child changed
+        changed_ = MAXI(changed_, (children_[active_])->changed());
+    }
 }
 
 void Switch::draw(glm::mat4 modelview, glm::mat4 projection)
@@ -382,7 +475,11 @@ void Switch::accept(Visitor& v)
 
 void Switch::setActive (uint index)
 {
-    active_ = CLAMP(index, 0, children_.size() - 1);
+    uint a = CLAMP(index, 0, children_.size() - 1);
+    if (a != active_) {
+        active_ = a;
+        touchStructure();
+    }
 }
 
 Node *Switch::child(uint index) const
@@ -398,6 +495,7 @@ uint Switch::attach(Node *child)
 {
     children_.push_back(child);
     child->refcount_++;
+    touchStructure();
 
     // make new child active
     active_ = children_.size() - 1;
@@ -416,6 +514,78 @@ void Switch::detatch(Node *child)
         // detatch child from group parent
         children_.erase(it);
         child->refcount_--;
+        touchStructure();
+    }
+}
+
+//
+// RenderList
+//
+
+RenderList::RenderList(Node *root) : root_(root), modelview_(glm::identity<glm::mat4>()), revision_(0), structure_(0)
+{
+
+}
+
+void RenderList::build(Node *node, glm::mat4 modelview)
+{
+    Item item;
+    item.modelview = modelview;
+    item.node = node;
+    item.end = 0;
+
+    Group *group = dynamic_cast<Group *>(node);
+    Switch *switcher = group ? nullptr : dynamic_cast<Switch *>(node);
+
+    // nodes drawing themselves
+    if (group == nullptr && switcher == nullptr) {
+        items_.push_back(item);
+        return;
+    }
+
+    // same as Group::draw and Switch::draw
+    if ( !node->initialized() )
+        node->init();
+
+    // content follows the group or switch
+    size_t index = items_.size();
+    items_.push_back(item);
+
+    glm::mat4 ctm = modelview * node->transform_;
+    if (group) {
+        for (NodeSet::iterator child = group->begin(); child != group->end(); child++)
+            build(*child, ctm);
+    }
+    else if (switcher->numChildren() > 0)
+        build(switcher->activeChild(), ctm);
+
+    items_[index].end = items_.size();
+}
+
+void RenderList::draw(glm::mat4 modelview, glm::mat4 projection)
+{
+    // rebuild list if a hierarchy changed (nodes could have been deleted),
+    // or if the graph of the root changed (since last update)
+    if ( structure_ != Node::structure() || revision_ != root_->changed()
+         || modelview_ != modelview || items_.empty() ) {
+        items_.clear();
+        modelview_ = modelview;
+        revision_ = root_->changed();
+        structure_ = Node::structure();
+        build(root_, modelview);
+    }
+
+    size_t i = 0;
+    while ( i < items_.size() ) {
+        const Item &item = items_[i];
+        // group or switch: skip content if not visible
+        if ( item.end > 0 )
+            i = item.node->visible_ ? i + 1 : item.end;
+        // draw node
+        else {
+            item.node->draw( item.modelview, projection );
+            ++i;
+        }
     }
 }
 
@@ -438,6 +608,8 @@ Scene::Scene()
     foreground_ = new Group;
     foreground_->translation_.z = SCENE_DEPTH -0.1f;
     root_->attach(foreground_);
+
+    renderlist_ = new RenderList(root_);
 }
 
 Scene::~Scene()
@@ -445,6 +617,7 @@ Scene::~Scene()
     clear();
     // bg and fg are deleted as children of root
     delete root_;
+    delete renderlist_;
 }
 
 
@@ -475,6 +648,11 @@ void Scene::update(float dt)
     root_->update( dt );
 }
 
+void Scene::draw(glm::mat4 projection)
+{
+    renderlist_->draw( glm::identity<glm::mat4>(), projection );
+}
+
 void Scene::accept(Visitor& v)
 {
     v.visit(*this);
@@ -41,8 +41,31 @@ class Group;
  */
 class Node {
 
+    friend class BoundingBoxVisitor;
+
     uint64_t  id_;
     bool      initialized_;
+    glm::vec3 updated_scale_, updated_rotation_, updated_translation_;
+    bool      updated_visible_;
+    // count of changes in all graphs, to order the revisions of nodes
+    static uint64_t revision_;
+    // revision of the last change of hierarchy in any graph
+    static uint64_t structure_;
+
+    // bounding box of the node computed by the last BoundingBoxVisitor
+    // with the given modelview, valid until changed()
+    struct {
+        GlmToolkit::AxisAlignedBoundingBox box;
+        glm::mat4 modelview;
+        uint64_t  changed;
+    } bbox_cache_;
+
+protected:
+    uint64_t  changed_;
+    inline void touch () { changed_ = ++revision_; }
+    // change of hierarchy (nodes attached, detached, deleted or reordered),
+    // known immediately, without waiting for the update of parents
+    inline void touchStructure () { touch(); structure_ = revision_; }
 
 public:
     Node ();
@@ -52,7 +75,7 @@ public:
     inline uint64_t id () const { return id_; }
 
     // must initialize the node before draw
-    virtual void init () { initialized_ = true; }
+    virtual void init () { initialized_ = true; touch(); }
     virtual bool initialized () { return initialized_; }
 
     // pure virtual draw : to be instanciated to define node behavior
@@ -66,6 +89,13 @@ public:
 
     void copyTransform (Node *other);
 
+    // revision of the last change of this node or of its children
+    // (children are accounted for at update)
+    inline uint64_t changed () const { return changed_; }
+
+    // revision of the last change of hierarchy in all graphs
+    static inline uint64_t structure () { return structure_; }
+
     // public members, to manipulate with care
     bool      visible_;
     uint      refcount_;
@@ -96,6 +126,8 @@ public:
  */
 class Primitive : public Node {
 
+    friend class InstanceBatch;
+
 public:
     Primitive(Shader *s = nullptr) : Node(), shader_(s), vao_(0), drawMode_(0), drawCount_(0) {}
     virtual ~Primitive();
@@ -130,9 +162,47 @@ struct z_comparator
         return (a && b && a->translation_.z < b->translation_.z);
     }
 };
-typedef std::multiset<Node*, z_comparator> NodeSet;
 
-//typedef std::list<Node*> NodeSet;
+/**
+ * @brief The NodeSet class is the depth-sorted list of children of a Group
+ *
+ * Nodes are kept in a contiguous array, ordered by depth (translation_.z)
+ * from furthest to closest, nodes at the same depth staying in order of
+ * insertion (as in a multiset).
+ *
+ * Insertion appends the node at the end, and invalidate() marks the set
+ * as unsorted (e.g. after a change of depth). The (stable) sort is done
+ * at the next call to begin().
+ */
+class NodeSet {
+
+public:
+    typedef std::vector<Node *>::iterator iterator;
+    typedef std::vector<Node *>::reverse_iterator reverse_iterator;
+
+    NodeSet() : sorted_(true) {}
+
+    void insert(Node *node);
+    iterator erase(iterator it);
+    inline void clear() { nodes_.clear(); sorted_ = true; }
+
+    iterator begin();
+    inline iterator end() { return nodes_.end(); }
+    reverse_iterator rbegin();
+    inline reverse_iterator rend() { return nodes_.rend(); }
+
+    inline size_t size() const { return nodes_.size(); }
+    inline bool empty() const { return nodes_.empty(); }
+
+    // sort at next begin()
+    inline void invalidate() { sorted_ = false; }
+    // invalidate if depth order is not respected (returns true if so)
+    bool check();
+
+private:
+    std::vector<Node *> nodes_;
+    bool sorted_;
+};
 
 struct hasId: public std::unary_function<Node*, bool>
 {
@@ -151,10 +221,11 @@ private:
  *
  * A Group defines the hierarchy in the scene graph.
  *
- * The list of Nodes* is a NodeSet, a depth-sorted set
- * accepting multiple nodes at the same depth (multiset)
+ * The list of Nodes* is a NodeSet, a depth-sorted list
+ * accepting multiple nodes at the same depth
  *
- * update() will update all children
+ * update() will update all children, and re-order them
+ * if their depth changed
  * draw() will draw all children
  *
  * When a group is deleted, the children are NOT deleted.
@@ -224,11 +295,58 @@ protected:
 };
 
 
+/**
+ * @brief The RenderList class is a flat list of the nodes of a graph
+ * in drawing order, each with its modelview matrix.
+ *
+ * The list is built in one traversal of the graph, and rebuilt only when
+ *  - the hierarchy of any graph changed (attach, detach, clear, sort or
+ *    active child of a Switch, see Node::structure()): immediately, as
+ *    the list could otherwise hold nodes detached or deleted since,
+ *  - or the transform of a node of its graph changed (see Node::changed()),
+ *    as known by its root after the update of the graph.
+ * Drawing is then a loop over a contiguous array, without recursion nor
+ * product of matrices.
+ *
+ * Groups and Switches are kept in the list before their content so that
+ * their visibility is tested when drawing: hiding a group does not
+ * require to rebuild the list.
+ *
+ * NB: the order of the list is the order of Group::draw (depth order of
+ * each group); it is not sorted by shader as there is no depth test and
+ * nodes are drawn on top of each other.
+ */
+class RenderList {
+
+public:
+    RenderList(Node *root);
+
+    void draw (glm::mat4 modelview, glm::mat4 projection);
+    inline size_t size () const { return items_.size(); }
+
+private:
+    struct Item {
+        glm::mat4 modelview;
+        Node *node;
+        // for groups and switches, index of the item after their content
+        size_t end;
+    };
+    std::vector<Item> items_;
+    Node *root_;
+    glm::mat4 modelview_;
+    uint64_t revision_;
+    uint64_t structure_;
+    void build (Node *node, glm::mat4 modelview);
+};
+
+
 /**
  * @brief A Scene holds a root node with 3 children; a background, a workspace and a foreground
  *
  * The update() is called on the root
  *
+ * The draw() is done with a RenderList of the root
+ *
  */
 class Scene  {
 
@@ -236,6 +354,7 @@ class Scene  {
     Group *background_;
     Group *workspace_;
     Group *foreground_;
+    RenderList *renderlist_;
 
 public:
     Scene();
@@ -243,6 +362,7 @@ public:
 
     void accept (Visitor& v);
     void update(float dt);
+    void draw(glm::mat4 projection);
 
     void clear();
     void clearBackground();
@@ -1,4 +1,6 @@
 #include <algorithm>
+#include <map>
+#include <chrono>
 
 #include "defines.h"
 #include "Settings.h"
@@ -10,7 +12,7 @@
 
 #include "Log.h"
 
-Session::Session() : failedSource_(nullptr), active_(true), fading_target_(0.f)
+Session::Session() : failedSource_(nullptr), active_(true), fading_target_(0.f), render_order_changed_(true)
 {
     filename_ = "";
 
@@ -60,20 +62,81 @@ void Session::setActive (bool on)
     }
 }
 
+// depth first traversal of dependencies to sort sources topologically
+typedef enum { UNSORTED = 0, SORTING, SORTED } SortStatus;
+static void sort_dependencies_(Source *s, const SourceList &sources, std::map<Source *, SortStatus> &status, SourceList &order)
+{
+    status[s] = SORTING;
+
+    SourceList deps = s->dependencies();
+    for (auto d = deps.begin(); d != deps.end(); d++) {
+        // ignore dependencies outside of this session
+        if ( std::find(sources.begin(), sources.end(), *d) == sources.end() )
+            continue;
+        // a dependency being sorted means there is a cycle: break it
+        if ( status[*d] == SORTING )
+            Log::Warning("Source %s depends on itself (through %s); ignoring this loop.", s->name().c_str(), (*d)->name().c_str());
+        else if ( status[*d] == UNSORTED )
+            sort_dependencies_(*d, sources, status, order);
+    }
+
+    status[s] = SORTED;
+    order.push_back(s);
+}
+
+void Session::sortRenderOrder()
+{
+    render_order_.clear();
+
+    std::map<Source *, SortStatus> status;
+    for( SourceList::iterator it = sources_.begin(); it != sources_.end(); it++) {
+        if ( status[*it] == UNSORTED )
+            sort_dependencies_(*it, sources_, status, render_order_);
+    }
+
+    render_order_changed_ = false;
+}
+
 // update all sources
 void Session::update(float dt)
 {
     failedSource_ = nullptr;
 
+    // producers shall be rendered before consumers
+    if (render_order_changed_)
+        sortRenderOrder();
+
+    // consumers tell their producers if their output is used
+    for( SourceList::reverse_iterator it = render_order_.rbegin(); it != render_order_.rend(); it++)
+        (*it)->evaluateConsumed();
+
+    // time spent initializing sources in this frame (ms)
+    float init_time = 0.f;
+
     // pre-render of all sources
-    for( SourceList::iterator it = sources_.begin(); it != sources_.end(); it++){
+    for( SourceList::iterator it = render_order_.begin(); it != render_order_.end(); it++){
 
         if ( (*it)->failed() ) {
             failedSource_ = (*it);
         }
-        else {
-            // render the source
+        else if ( !(*it)->ready() ) {
+            // initialization (OpenGL and pipelines) of many sources is spread
+            // over the next frames when it takes more than the budget
+            if ( init_time > SESSION_INIT_BUDGET )
+                continue;
+            auto start = std::chrono::high_resolution_clock::now();
+            (*it)->updateLod( frame()->resolution() );
             (*it)->render();
+            (*it)->update(dt);
+            std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+            init_time += elapsed.count();
+        }
+        else {
+            // adjust the resolution of the source to its size in the output
+            bool resized = (*it)->updateLod( frame()->resolution() );
+            // render the source, only if its output is used
+            if ( (*it)->consumed() || resized )
+                (*it)->render();
             // update the source
             (*it)->update(dt);
         }
@@ -112,6 +175,7 @@ SourceList::iterator Session::addSource(Source *s)
 
         // insert the source to the beginning of the list
         sources_.push_front(s);
+        render_order_changed_ = true;
     }
 
     // unlock access
@@ -136,6 +200,7 @@ SourceList::iterator Session::deleteSource(Source *s)
 
         // erase the source from the update list & get next element
         its = sources_.erase(its);
+        render_order_changed_ = true;
 
         // delete the source : safe now
         delete s;
@@ -164,6 +229,7 @@ void Session::removeSource(Source *s)
 
         // erase the source from the update list & get next element
         sources_.erase(its);
+        render_order_changed_ = true;
     }
 
     // unlock access
@@ -185,6 +251,7 @@ Source *Session::popSource()
 
         // erase the source from the update list & get next element
         sources_.erase(its);
+        render_order_changed_ = true;
     }
 
     return s;
@@ -295,9 +362,9 @@ void Session::unlock()
 }
 
 
-Session *Session::load(const std::string& filename)
+Session *Session::load(const std::string& filename, uint recursion)
 {
-    SessionCreator creator;
+    SessionCreator creator(recursion);
     creator.load(filename);
 
     return creator.session();
@@ -14,7 +14,9 @@ public:
     Session();
     ~Session();
 
-    static Session *load(const std::string& filename);
+    // load a session file; recursion is the nesting level of the session
+    // (sessions in session sources), limited to MAX_SESSION_LEVEL
+    static Session *load(const std::string& filename, uint recursion = 0);
 
     // add given source into the session
     SourceList::iterator addSource (Source *s);
@@ -86,6 +88,11 @@ protected:
     std::list<FrameGrabber *> grabbers_;
     float fading_target_;
     std::mutex access_;
+
+    // render graph: sources sorted with producers before their consumers
+    SourceList render_order_;
+    bool render_order_changed_;
+    void sortRenderOrder();
 };
 
 
@@ -15,6 +15,7 @@
 #include "Session.h"
 #include "ImageShader.h"
 #include "ImageProcessingShader.h"
+#include "EffectChain.h"
 #include "MediaPlayer.h"
 
 #include <tinyxml2.h>
@@ -52,8 +53,9 @@ std::string SessionCreator::info(const std::string& filename)
     return ret;
 }
 
-SessionCreator::SessionCreator(): SessionLoader(nullptr)
+SessionCreator::SessionCreator(uint recursion): SessionLoader(nullptr)
 {
+    recursion_ = recursion;
 
 }
 
@@ -104,7 +106,7 @@ void SessionCreator::loadConfig(XMLElement *viewsNode)
     }
 }
 
-SessionLoader::SessionLoader(Session *session): Visitor(), session_(session)
+SessionLoader::SessionLoader(Session *session): Visitor(), session_(session), recursion_(0)
 {
 
 }
@@ -493,6 +495,18 @@ void SessionLoader::visit (Source& s)
     s.processingShader()->accept(*this);
     s.setImageProcessingEnabled(on);
 
+    s.effects()->clear();
+    XMLElement* effects = sourceNode->FirstChildElement("Effects");
+    if (effects) {
+        XMLElement* pass = effects->FirstChildElement("Pass");
+        for( ; pass ; pass = pass->NextSiblingElement("Pass")) {
+            const char *name = pass->Attribute("name");
+            const char *code = pass->GetText();
+            EffectPass *p = s.effects()->add(name ? name : "", code ? code : "");
+            p->enabled = pass->BoolAttribute("enabled", true);
+        }
+    }
+
     // restore current
     xmlCurrent_ = sourceNode;
 }
@@ -520,7 +534,7 @@ void SessionLoader::visit (SessionSource& s)
         std::string path = std::string ( pathNode->GetText() );
         // load only new files
         if ( path != s.path() )
-            s.load(path);
+            s.load(path, recursion_ + 1);
     }
 
 }
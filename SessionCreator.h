@@ -55,6 +55,7 @@ protected:
     tinyxml2::XMLElement *xmlCurrent_;
     Session *session_;
     std::list<uint64_t> sources_id_;
+    uint recursion_;
 
     static void XMLToNode(tinyxml2::XMLElement *xml, Node &n);
 };
@@ -66,7 +67,7 @@ class SessionCreator : public SessionLoader {
     void loadConfig(tinyxml2::XMLElement *viewsNode);
 
 public:
-    SessionCreator();
+    SessionCreator(uint recursion = 0);
 
     void load(const std::string& filename);
 
@@ -62,16 +62,22 @@ SessionSource::~SessionSource()
         delete session_;
 }
 
-void SessionSource::load(const std::string &p)
+void SessionSource::load(const std::string &p, uint recursion)
 {
     path_ = p;
 
     if ( path_.empty() )
         // empty session
         session_ = new Session;
+    else if ( recursion > MAX_SESSION_LEVEL ) {
+        // a session including itself (directly or not) would load forever
+        Log::Warning("Session %s is nested too deeply (or includes itself); not loaded.", path_.c_str());
+        failed_ = true;
+        return;
+    }
     else
         // launch a thread to load the session file
-        sessionLoader_ = std::async(std::launch::async, Session::load, path_);
+        sessionLoader_ = std::async(std::launch::async, Session::load, path_, recursion);
 
     Log::Notify("Opening %s", p.c_str());
 }
@@ -103,12 +109,20 @@ uint SessionSource::texture() const
     return session_->frame()->texture();
 }
 
+size_t SessionSource::memory() const
+{
+    if (session_ == nullptr)
+        return Source::memory();
+    // NB: sources inside the session are not counted
+    return Source::memory() + session_->frame()->memory();
+}
+
 void SessionSource::init()
 {
     // init is first about getting the loaded session
     if (session_ == nullptr) {
         // did the loader finish ?
-        if (sessionLoader_.wait_for(std::chrono::milliseconds(4)) == std::future_status::ready) {
+        if (sessionLoader_.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready) {
             session_ = sessionLoader_.get();
             if (session_ == nullptr)
                 failed_ = true;
@@ -191,8 +205,8 @@ void SessionSource::update(float dt)
     if (session_ == nullptr)
         return;
 
-    // update content
-    if (active_)
+    // update content, only if the output of the session is used
+    if (active_ && (consumed_ || !initialized_))
         session_->update(dt);
 
     // delete a source which failed
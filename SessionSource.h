@@ -16,10 +16,11 @@ public:
     void setActive (bool on) override;
     bool failed() const override;
     uint texture() const override;
+    size_t memory() const override;
     void accept (Visitor& v) override;
 
     // Session Source specific interface
-    void load(const std::string &p = "");
+    void load(const std::string &p = "", uint recursion = 0);
     Session *detach();
 
     inline std::string path() const { return path_; }
@@ -41,6 +42,8 @@ protected:
 };
 
 
+// NB: a RenderSource reads the previous frame of its session, so it is not
+// a dependency in the render graph of the session (one frame feedback)
 class RenderSource : public Source
 {
 public:
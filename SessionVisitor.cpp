@@ -11,6 +11,7 @@
 #include "NetworkSource.h"
 #include "ImageShader.h"
 #include "ImageProcessingShader.h"
+#include "EffectChain.h"
 #include "MediaPlayer.h"
 
 #include <iostream>
@@ -356,6 +357,21 @@ void SessionVisitor::visit (Source& s)
     sourceNode->InsertEndChild(xmlCurrent_);
     s.processingShader()->accept(*this);
 
+    if ( s.effects()->size() > 0 ) {
+        xmlCurrent_ = xmlDoc_->NewElement( "Effects" );
+        sourceNode->InsertEndChild(xmlCurrent_);
+        for (size_t i = 0; i < s.effects()->size(); ++i) {
+            EffectPass *p = s.effects()->pass(i);
+            XMLElement *pass = xmlDoc_->NewElement( "Pass" );
+            pass->SetAttribute("name", p->name.c_str());
+            pass->SetAttribute("enabled", p->enabled);
+            XMLText *code = xmlDoc_->NewText( p->code().c_str() );
+            code->SetCData(true);
+            pass->InsertEndChild(code);
+            xmlCurrent_->InsertEndChild(pass);
+        }
+    }
+
     xmlCurrent_ = sourceNode;  // parent for next visits (other subtypes of Source)
 }
 
@@ -84,6 +84,11 @@ void Settings::Save()
     RenderNode->SetAttribute("blit", application.render.blit);
     RenderNode->SetAttribute("ratio", application.render.ratio);
     RenderNode->SetAttribute("res", application.render.res);
+    RenderNode->SetAttribute("gpu_budget", application.render.gpu_budget);
+    RenderNode->SetAttribute("lod", application.render.lod);
+    RenderNode->SetAttribute("shader_cache", application.render.shader_cache);
+    RenderNode->SetAttribute("texture_compression", application.render.texture_compression);
+    RenderNode->SetAttribute("texture_cache", application.render.texture_cache);
     pRoot->InsertEndChild(RenderNode);
 
     // Record
@@ -93,6 +98,12 @@ void Settings::Save()
     RecordNode->SetAttribute("timeout", application.record.timeout);
     pRoot->InsertEndChild(RecordNode);
 
+    // Streaming
+    XMLElement *StreamingNode = xmlDoc.NewElement( "Streaming" );
+    StreamingNode->SetAttribute("protocol", application.stream.protocol);
+    StreamingNode->SetAttribute("test_loss", application.stream.test_loss);
+    pRoot->InsertEndChild(StreamingNode);
+
     // Transition
     XMLElement *TransitionNode = xmlDoc.NewElement( "Transition" );
     TransitionNode->SetAttribute("auto_open", application.transition.auto_open);
@@ -266,6 +277,11 @@ void Settings::Load()
         rendernode->QueryBoolAttribute("blit", &application.render.blit);
         rendernode->QueryIntAttribute("ratio", &application.render.ratio);
         rendernode->QueryIntAttribute("res", &application.render.res);
+        rendernode->QueryIntAttribute("gpu_budget", &application.render.gpu_budget);
+        rendernode->QueryBoolAttribute("lod", &application.render.lod);
+        rendernode->QueryBoolAttribute("shader_cache", &application.render.shader_cache);
+        rendernode->QueryBoolAttribute("texture_compression", &application.render.texture_compression);
+        rendernode->QueryIntAttribute("texture_cache", &application.render.texture_cache);
     }
 
     // Record
@@ -281,6 +297,13 @@ void Settings::Load()
             application.record.path = SystemToolkit::home_path();
     }
 
+    // Streaming
+    XMLElement * streamingnode = pRoot->FirstChildElement("Streaming");
+    if (streamingnode != nullptr) {
+        streamingnode->QueryIntAttribute("protocol", &application.stream.protocol);
+        streamingnode->QueryFloatAttribute("test_loss", &application.stream.test_loss);
+    }
+
     // Source
     XMLElement * sourceconfnode = pRoot->FirstChildElement("Source");
     if (sourceconfnode != nullptr) {
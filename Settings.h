@@ -77,6 +77,18 @@ struct RecordConfig
 
 };
 
+struct StreamingConfig
+{
+    int protocol;
+    float test_loss;
+
+    StreamingConfig() {
+        protocol = 1; // NetworkToolkit::UDP_JPEG
+        test_loss = 0.05f;
+    }
+
+};
+
 struct History
 {
     std::string path;
@@ -136,6 +148,11 @@ struct RenderConfig
     int ratio;
     int res;
     float fading;
+    int gpu_budget;
+    bool lod;
+    bool shader_cache;
+    bool texture_compression;
+    int texture_cache;
 
     RenderConfig() {
         blit = false;
@@ -144,6 +161,11 @@ struct RenderConfig
         ratio = 3;
         res = 1;
         fading = 0.0;
+        gpu_budget = 2048; // MB
+        lod = false;
+        shader_cache = true;
+        texture_compression = false;
+        texture_cache = 256; // MB
     }
 };
 
@@ -196,6 +218,9 @@ struct Application
     // settings exporters
     RecordConfig record;
 
+    // settings network streaming
+    StreamingConfig stream;
+
     // settings new source
     SourceConfig source;
 
@@ -3,12 +3,19 @@
 #include "Log.h"
 #include "Visitor.h"
 #include "RenderingManager.h"
+#include "SystemToolkit.h"
+#include "Settings.h"
 
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <chrono>
 #include <ctime>
+#include <iterator>
+#include <functional>
+#include <algorithm>
+#include <sys/stat.h>
+#include <utime.h>
 
 #include <glad/glad.h> 
 #include <GLFW/glfw3.h>
@@ -20,7 +27,12 @@
 
 // Globals
 ShadingProgram *ShadingProgram::currentProgram_ = nullptr;
+unsigned int ShadingProgram::calls_ = 0;
+unsigned int ShadingProgram::last_calls_ = 0;
+const char* ShadingProgram::uniform_names[UNIFORM_COUNT] = { "projection", "modelview", "iTransform", "color", "iResolution", "stipple" };
+const char* ShadingProgram::uniform_block_names[BLOCK_COUNT] = { "ImageProcessing" };
 ShadingProgram simpleShadingProgram("shaders/simple.vs", "shaders/simple.fs");
+ShadingProgram simpleInstancedShadingProgram("shaders/instanced.vs", "shaders/simple.fs");
 
 // Blending presets for matching with Shader::BlendMode
 GLenum blending_equation[6] = { GL_FUNC_ADD, GL_FUNC_ADD, GL_FUNC_REVERSE_SUBTRACT, GL_FUNC_ADD, GL_FUNC_REVERSE_SUBTRACT, GL_FUNC_ADD};
@@ -29,18 +41,44 @@ GLenum blending_destination_function[6] = {GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ON
 
 
 
-ShadingProgram::ShadingProgram(const std::string& vertex_file, const std::string& fragment_file) : vertex_id_(0), fragment_id_(0), id_(0)
+ShadingProgram::ShadingProgram(const std::string& vertex_file, const std::string& fragment_file,
+                               const std::string& defines, const std::string& code) :
+    vertex_id_(0), fragment_id_(0), id_(0), valid_(false), binary_cache_(true)
 {
     vertex_file_ = vertex_file;
     fragment_file_ = fragment_file;
+    defines_ = defines;
+    code_ = code;
+    for (int u = 0; u < UNIFORM_COUNT; ++u)
+        uniform_locations_[u] = -1;
 }
 
 void ShadingProgram::init()
 {
     vertex_code_ = Resource::getText(vertex_file_);
     fragment_code_ = Resource::getText(fragment_file_);
-	compile();
-	link();
+    // insert defines after the #version directive
+    if (!defines_.empty()) {
+        size_t pos = fragment_code_.find('\n');
+        fragment_code_.insert(pos == std::string::npos ? fragment_code_.size() : pos + 1, defines_);
+    }
+    fragment_code_ += code_;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    bool cache = binary_cache_ && Settings::application.render.shader_cache;
+
+    // use binary of previous compilation if possible
+    bool loaded = cache && loadBinary();
+    if ( !loaded ) {
+        compile();
+        link();
+        if ( cache && valid_ )
+            saveBinary();
+    }
+
+    // timing to compare compilation and loading from cache
+    std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    Log::Info("Shader %s %s in %.1f ms", fragment_file_.c_str(), loaded ? "loaded" : "compiled", elapsed.count());
 }
 
 bool ShadingProgram::initialized()
@@ -48,6 +86,19 @@ bool ShadingProgram::initialized()
     return (id_ != 0);
 }
 
+void ShadingProgram::release()
+{
+    if (id_)
+        glDeleteProgram(id_);
+    id_ = 0;
+    valid_ = false;
+    locations_.clear();
+
+    // another program could be created at the same address
+    if (currentProgram_ == this)
+        currentProgram_ = nullptr;
+}
+
 void ShadingProgram::compile()
 {
     const char* vcode = vertex_code_.c_str();
@@ -68,14 +119,168 @@ void ShadingProgram::link()
     id_ = glCreateProgram();
     glAttachShader(id_, vertex_id_);
     glAttachShader(id_, fragment_id_);
+    if ( binary_cache_ && GLAD_GL_ARB_get_program_binary )
+        glProgramParameteri(id_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(id_);
     checkLinkingErr();
+    glDeleteShader(vertex_id_);
+    glDeleteShader(fragment_id_);
+    setup();
+}
+
+void ShadingProgram::setup()
+{
     glUseProgram(id_);
     glUniform1i(glGetUniformLocation(id_, "iChannel0"), 0);
     glUniform1i(glGetUniformLocation(id_, "iChannel1"), 1);
+    // read locations of uniforms once (-1 if not used by the program)
+    for (int u = 0; u < UNIFORM_COUNT; ++u)
+        uniform_locations_[u] = glGetUniformLocation(id_, uniform_names[u]);
+    // bind uniform blocks of the program to their binding point
+    for (unsigned int b = 0; b < BLOCK_COUNT; ++b) {
+        GLuint index = glGetUniformBlockIndex(id_, uniform_block_names[b]);
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(id_, index, b);
+    }
     glUseProgram(0);
-    glDeleteShader(vertex_id_);
-    glDeleteShader(fragment_id_);
+}
+
+// header of program binary files
+#define BINARY_MAGIC 0x56584250 // 'VXBP'
+// binary files kept on disk (least recently used are removed)
+#define BINARY_CACHE_MAX_FILES 100
+struct BinaryHeader {
+    uint32_t magic;
+    uint32_t format;
+    uint64_t source;
+    uint64_t driver;
+};
+
+std::string ShadingProgram::binaryKey() const
+{
+    // the binary depends on the driver
+    std::string driver = (const char *) glGetString(GL_VENDOR);
+    driver += (const char *) glGetString(GL_RENDERER);
+    driver += (const char *) glGetString(GL_VERSION);
+    return driver;
+}
+
+std::string ShadingProgram::binaryFilename() const
+{
+    // one file per source and driver
+    size_t h = std::hash<std::string>{}(vertex_code_ + fragment_code_ + binaryKey());
+    std::string path = SystemToolkit::full_filename(SystemToolkit::settings_path(), "shaders");
+    return SystemToolkit::full_filename(path, std::to_string(h) + ".bin");
+}
+
+bool ShadingProgram::loadBinary()
+{
+    if ( !GLAD_GL_ARB_get_program_binary )
+        return false;
+
+    std::string filename = binaryFilename();
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    // file is a header followed by the binary
+    BinaryHeader header = { 0, 0, 0, 0 };
+    file.read((char *) &header, sizeof(BinaryHeader));
+    bool complete = file.gcount() == sizeof(BinaryHeader);
+    std::vector<char> binary( (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>() );
+
+    // validate the file was made for this source and driver
+    if ( !complete || header.magic != BINARY_MAGIC || binary.empty()
+         || header.source != std::hash<std::string>{}(vertex_code_ + fragment_code_)
+         || header.driver != std::hash<std::string>{}(binaryKey()) ) {
+        Log::Info("Shader %s : invalid cache file %s", fragment_file_.c_str(), filename.c_str());
+        return false;
+    }
+
+    id_ = glCreateProgram();
+    glProgramBinary(id_, header.format, binary.data(), (GLsizei) binary.size());
+
+    // driver may reject the binary (e.g. after update) : compile again
+    int success = 0;
+    glGetProgramiv(id_, GL_LINK_STATUS, &success);
+    if (!success) {
+        Log::Info("Shader %s : cache rejected by driver", fragment_file_.c_str());
+        glDeleteProgram(id_);
+        id_ = 0;
+        return false;
+    }
+
+    valid_ = true;
+    setup();
+
+    // recently used: not to be removed when pruning the cache
+    utime(filename.c_str(), NULL);
+
+    return true;
+}
+
+// remove the least recently used binary files above the maximum
+static void pruneBinaryCache(const std::string &path)
+{
+    std::list<std::string> files = SystemToolkit::list_directory(path, "bin");
+    if ( files.size() <= BINARY_CACHE_MAX_FILES )
+        return;
+
+    std::vector< std::pair<time_t, std::string> > ages;
+    for (auto it = files.begin(); it != files.end(); it++) {
+        struct stat info;
+        if ( stat(it->c_str(), &info) == 0 )
+            ages.push_back( std::make_pair(info.st_mtime, *it) );
+    }
+    std::sort(ages.begin(), ages.end());
+    for (size_t i = 0; i + BINARY_CACHE_MAX_FILES < ages.size(); ++i)
+        SystemToolkit::remove_file(ages[i].second);
+}
+
+void ShadingProgram::saveBinary()
+{
+    if ( !GLAD_GL_ARB_get_program_binary )
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(id_, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length < 1)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(id_, length, NULL, &format, binary.data());
+
+    std::string path = SystemToolkit::full_filename(SystemToolkit::settings_path(), "shaders");
+    if ( !SystemToolkit::file_exists(path) )
+        SystemToolkit::create_directory(path);
+
+    BinaryHeader header;
+    header.magic = BINARY_MAGIC;
+    header.format = format;
+    header.source = std::hash<std::string>{}(vertex_code_ + fragment_code_);
+    header.driver = std::hash<std::string>{}(binaryKey());
+
+    // (overwrites an invalid file)
+    std::ofstream file(binaryFilename(), std::ios::binary | std::ios::trunc);
+    if (file.is_open()) {
+        file.write((const char *) &header, sizeof(BinaryHeader));
+        file.write(binary.data(), length);
+        file.close();
+    }
+
+    pruneBinaryCache(path);
+}
+
+void ShadingProgram::removeBinary()
+{
+    // source code is known after init
+    if ( !binary_cache_ || fragment_code_.empty() )
+        return;
+
+    std::string filename = binaryFilename();
+    if ( SystemToolkit::file_exists(filename) )
+        SystemToolkit::remove_file(filename);
 }
 
 void ShadingProgram::use()
@@ -84,6 +289,7 @@ void ShadingProgram::use()
     {
         currentProgram_ = this;
         glUseProgram(id_);
+        count();
     }
 }
 
@@ -93,47 +299,108 @@ void ShadingProgram::enduse()
     currentProgram_ = nullptr ;
 }
 
+void ShadingProgram::endFrame()
+{
+    last_calls_ = calls_;
+    calls_ = 0;
+}
+
+unsigned int ShadingProgram::calls()
+{
+    return last_calls_;
+}
+
+int ShadingProgram::location(const std::string& name)
+{
+    // get location from the program only the first time
+    auto it = locations_.find(name);
+    if (it != locations_.end())
+        return it->second;
+
+    int l = glGetUniformLocation(id_, name.c_str());
+    count();
+    locations_[name] = l;
+    return l;
+}
+
 template<>
 void ShadingProgram::setUniform<int>(const std::string& name, int val) {
-	glUniform1i(glGetUniformLocation(id_, name.c_str()), val);
+	glUniform1i(location(name), val);
+    count();
 }
 
 template<>
 void ShadingProgram::setUniform<bool>(const std::string& name, bool val) {
-	glUniform1i(glGetUniformLocation(id_, name.c_str()), val);
+	glUniform1i(location(name), val);
+    count();
 }
 
 template<>
 void ShadingProgram::setUniform<float>(const std::string& name, float val) {
-	glUniform1f(glGetUniformLocation(id_, name.c_str()), val);
+	glUniform1f(location(name), val);
+    count();
 }
 
 template<>
 void ShadingProgram::setUniform<float>(const std::string& name, float val1, float val2) {
-    glUniform2f(glGetUniformLocation(id_, name.c_str()), val1, val2);
+    glUniform2f(location(name), val1, val2);
+    count();
 }
 
 template<>
 void ShadingProgram::setUniform<float>(const std::string& name, float val1, float val2, float val3) {
-    glUniform3f(glGetUniformLocation(id_, name.c_str()), val1, val2, val3);
+    glUniform3f(location(name), val1, val2, val3);
+    count();
 }
 
 template<>
 void ShadingProgram::setUniform<glm::vec4>(const std::string& name, glm::vec4 val) {
     glm::vec4 v(val);
-    glUniform4fv(glGetUniformLocation(id_, name.c_str()), 1, glm::value_ptr(v));
+    glUniform4fv(location(name), 1, glm::value_ptr(v));
+    count();
 }
 
 template<>
 void ShadingProgram::setUniform<glm::vec3>(const std::string& name, glm::vec3 val) {
     glm::vec3 v(val);
-    glUniform4fv(glGetUniformLocation(id_, name.c_str()), 1, glm::value_ptr(v));
+    glUniform3fv(location(name), 1, glm::value_ptr(v));
+    count();
 }
 
 template<>
 void ShadingProgram::setUniform<glm::mat4>(const std::string& name, glm::mat4 val) {
     glm::mat4 m(val);
-	glUniformMatrix4fv(glGetUniformLocation(id_, name.c_str()), 1, GL_FALSE, glm::value_ptr(m));
+	glUniformMatrix4fv(location(name), 1, GL_FALSE, glm::value_ptr(m));
+    count();
+}
+
+
+template<>
+void ShadingProgram::setUniform<float>(Uniform u, float val) {
+    if (uniform_locations_[u] < 0) return;
+    glUniform1f(uniform_locations_[u], val);
+    count();
+}
+
+template<>
+void ShadingProgram::setUniform<glm::vec3>(Uniform u, glm::vec3 val) {
+    if (uniform_locations_[u] < 0) return;
+    glUniform3fv(uniform_locations_[u], 1, glm::value_ptr(val));
+    count();
+}
+
+template<>
+void ShadingProgram::setUniform<glm::vec4>(Uniform u, glm::vec4 val) {
+    if (uniform_locations_[u] < 0) return;
+    glUniform4fv(uniform_locations_[u], 1, glm::value_ptr(val));
+    count();
+}
+
+template<>
+void ShadingProgram::setUniform<glm::mat4>(Uniform u, glm::mat4 val) {
+    if (uniform_locations_[u] < 0) return;
+    glUniformMatrix4fv(uniform_locations_[u], 1, GL_FALSE, glm::value_ptr(val));
+    count();
 }
 
 
@@ -163,6 +430,7 @@ void ShadingProgram::checkLinkingErr()
 	int success;
 	char infoLog[1024];
 	glGetProgramiv(id_, GL_LINK_STATUS, &success);
+    valid_ = success;
 	if (!success) {
 		glGetProgramInfoLog(id_, 1024, NULL, infoLog);
         Log::Warning("Error linking ShadingProgram:\n%s", infoLog);
@@ -189,10 +457,35 @@ void Shader::operator = (const Shader &S )
     iTransform = S.iTransform;
 }
 
+bool Shader::operator == (const Shader &S ) const
+{
+    return color == S.color && blending == S.blending && iTransform == S.iTransform;
+}
+
 void Shader::accept(Visitor& v) {
     v.visit(*this);
 }
 
+ShadingProgram *Shader::instancedProgram() const
+{
+    return program_ == &simpleShadingProgram ? &simpleInstancedShadingProgram : nullptr;
+}
+
+bool Shader::useInstanced()
+{
+    ShadingProgram *instanced = instancedProgram();
+    if (instanced == nullptr)
+        return false;
+
+    // use the shader with the instanced program in place of its own
+    ShadingProgram *program = program_;
+    program_ = instanced;
+    use();
+    program_ = program;
+
+    return true;
+}
+
 void Shader::use()
 {
     // initialization on first use
@@ -203,33 +496,36 @@ void Shader::use()
     program_->use();
 
     // set uniforms
-    program_->setUniform("projection", projection);
-    program_->setUniform("modelview", modelview);
-    program_->setUniform("iTransform", iTransform);
-    program_->setUniform("color", color);
+    program_->setUniform(ShadingProgram::UNIFORM_PROJECTION, projection);
+    program_->setUniform(ShadingProgram::UNIFORM_MODELVIEW, modelview);
+    program_->setUniform(ShadingProgram::UNIFORM_ITRANSFORM, iTransform);
+    program_->setUniform(ShadingProgram::UNIFORM_COLOR, color);
 
     iResolution = glm::vec3( Rendering::manager().currentAttrib().viewport, 0.f);
-    program_->setUniform("iResolution", iResolution);
+    program_->setUniform(ShadingProgram::UNIFORM_IRESOLUTION, iResolution);
 
     // Blending Function
     if (force_blending_opacity) {
         glEnable(GL_BLEND);
         glBlendEquation(blending_equation[BLEND_OPACITY]);
         glBlendFunc(blending_source_function[BLEND_OPACITY], blending_destination_function[BLEND_OPACITY]);
-
+        ShadingProgram::count(3);
     }
     else if ( blending != BLEND_CUSTOM ) {
         glEnable(GL_BLEND);
         glBlendEquation(blending_equation[blending]);
         glBlendFunc(blending_source_function[blending], blending_destination_function[blending]);
+        ShadingProgram::count(3);
 
         // TODO different blending for alpha and color
         //        glBlendEquationSeparate(blending_equation[blending], GL_FUNC_ADD);
         //        glBlendFuncSeparate(blending_source_function[blending], blending_destination_function[blending], GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     }
-    else
+    else {
         glDisable(GL_BLEND);
+        ShadingProgram::count();
+    }
 }
 
 
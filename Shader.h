@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <map>
 #include <glm/glm.hpp>
 
 // Forward declare classes referenced
@@ -11,28 +12,81 @@ class Visitor;
 class ShadingProgram
 {
 public:
-    ShadingProgram(const std::string& vertex_file, const std::string& fragment_file);
+    // optional preprocessor defines are inserted after the #version
+    // line of the fragment shader (e.g. "#define FEATURE\n"), and
+    // optional code is appended to the fragment shader (e.g. functions
+    // declared in the fragment shader file)
+    ShadingProgram(const std::string& vertex_file, const std::string& fragment_file,
+                   const std::string& defines = "", const std::string& code = "");
     void init();
     bool initialized();
+    // delete the OpenGL program (init again to use)
+    void release();
+    // true if compiled and linked without error (after init)
+    inline bool valid() const { return valid_; }
+    // keep the program binary on disk to skip compilation at next init
+    // (default, if enabled in Settings::application.render.shader_cache)
+    inline void setBinaryCache(bool on) { binary_cache_ = on; }
+    // remove the binary kept on disk (program not to be used again)
+    void removeBinary();
     void use();
 	template<typename T> void setUniform(const std::string& name, T val);
 	template<typename T> void setUniform(const std::string& name, T val1, T val2);
 	template<typename T> void setUniform(const std::string& name, T val1, T val2, T val3);
 
+    // uniforms used by the Shader classes, with locations read at link
+    typedef enum {
+        UNIFORM_PROJECTION = 0,
+        UNIFORM_MODELVIEW,
+        UNIFORM_ITRANSFORM,
+        UNIFORM_COLOR,
+        UNIFORM_IRESOLUTION,
+        UNIFORM_STIPPLE,
+        UNIFORM_COUNT
+    } Uniform;
+    static const char* uniform_names[UNIFORM_COUNT];
+    template<typename T> void setUniform(Uniform u, T val);
+
+    // uniform blocks (std140), bound to the binding point of their index
+    typedef enum {
+        BLOCK_IMAGEPROCESSING = 0,
+        BLOCK_COUNT
+    } UniformBlock;
+    static const char* uniform_block_names[BLOCK_COUNT];
+
 	static void enduse();
 
+    // count of OpenGL calls made to use programs and set their uniforms
+    // (calls() gives the count of the last frame ended by endFrame())
+    static inline void count(unsigned int n = 1) { calls_ += n; }
+    static void endFrame();
+    static unsigned int calls();
+
 private:
 	void checkCompileErr();
 	void checkLinkingErr();
 	void compile();
 	void link();
+    void setup();
+    std::string binaryKey() const;
+    std::string binaryFilename() const;
+    bool loadBinary();
+    void saveBinary();
+    int location(const std::string& name);
 	unsigned int vertex_id_, fragment_id_, id_;
 	std::string vertex_code_;
 	std::string fragment_code_;
     std::string vertex_file_;
     std::string fragment_file_;
+    std::string defines_;
+    std::string code_;
+    bool valid_;
+    bool binary_cache_;
+    int uniform_locations_[UNIFORM_COUNT];
+    std::map<std::string, int> locations_;
 
     static ShadingProgram *currentProgram_;
+    static unsigned int calls_, last_calls_;
 };
 
 class Shader
@@ -50,7 +104,13 @@ public:
     virtual void reset();
     virtual void accept(Visitor& v);
 
+    // version of the program reading modelview and color from per-instance
+    // attributes (nullptr if not available), used by InstanceBatch
+    virtual ShadingProgram *instancedProgram() const;
+    bool useInstanced();
+
     void operator = (const Shader &D );
+    bool operator == (const Shader &D ) const;
 
     glm::mat4 projection;
     glm::mat4 modelview;
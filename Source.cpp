@@ -13,19 +13,28 @@
 #include "SearchVisitor.h"
 #include "ImageShader.h"
 #include "ImageProcessingShader.h"
+#include "ImageFilter.h"
+#include "EffectChain.h"
 #include "Log.h"
+#include "Settings.h"
 #include "Mixer.h"
 
-Source::Source() : initialized_(false), active_(true), need_update_(true), symbol_(nullptr)
+Source::Source() : initialized_(false), lod_(0), active_(true), consumed_(true), need_update_(true), symbol_(nullptr)
 {
     // create unique id
     id_ = GlmToolkit::uniqueId();
 
+    creation_time_ = std::chrono::high_resolution_clock::now();
+    load_time_ = 0.f;
+
     sprintf(initials_, "__");
     name_ = "Source";
     mode_ = Source::UNINITIALIZED;
 
     // create groups and overlays for each view
+    // (frames, handles and icons are created at first display, in decorate())
+    for (int v = View::RENDERING; v < View::INVALID; v++)
+        decorated_[v] = false;
 
     // default rendering node
     groups_[View::RENDERING] = new Group;
@@ -38,21 +47,11 @@ Source::Source() : initialized_(false), active_(true), need_update_(true), symbo
     groups_[View::MIXING]->translation_ = glm::vec3(DEFAULT_MIXING_TRANSLATION, 0.f);
 
     frames_[View::MIXING] = new Switch;
-    Frame *frame = new Frame(Frame::ROUND, Frame::THIN, Frame::DROP);
-    frame->translation_.z = 0.1;
-    frame->color = glm::vec4( COLOR_DEFAULT_SOURCE, 0.9f);
-    frames_[View::MIXING]->attach(frame);
-    frame = new Frame(Frame::ROUND, Frame::LARGE, Frame::DROP);
-    frame->translation_.z = 0.01;
-    frame->color = glm::vec4( COLOR_HIGHLIGHT_SOURCE, 1.f);
-    frames_[View::MIXING]->attach(frame);
     groups_[View::MIXING]->attach(frames_[View::MIXING]);
 
     overlays_[View::MIXING] = new Group;
     overlays_[View::MIXING]->translation_.z = 0.1;
     overlays_[View::MIXING]->visible_ = false;
-    Symbol *center = new Symbol(Symbol::CIRCLE_POINT, glm::vec3(0.f, 0.f, 0.1f));
-    overlays_[View::MIXING]->attach(center);
     groups_[View::MIXING]->attach(overlays_[View::MIXING]);
 
     // default geometry nodes
@@ -60,48 +59,11 @@ Source::Source() : initialized_(false), active_(true), need_update_(true), symbo
     groups_[View::GEOMETRY]->visible_ = false;
 
     frames_[View::GEOMETRY] = new Switch;
-    frame = new Frame(Frame::SHARP, Frame::THIN, Frame::NONE);
-    frame->translation_.z = 0.1;
-    frame->color = glm::vec4( COLOR_DEFAULT_SOURCE, 0.7f);
-    frames_[View::GEOMETRY]->attach(frame);
-    frame = new Frame(Frame::SHARP, Frame::LARGE, Frame::GLOW);
-    frame->translation_.z = 0.1;
-    frame->color = glm::vec4( COLOR_HIGHLIGHT_SOURCE, 1.f);
-    frames_[View::GEOMETRY]->attach(frame);
     groups_[View::GEOMETRY]->attach(frames_[View::GEOMETRY]);
 
     overlays_[View::GEOMETRY] = new Group;
     overlays_[View::GEOMETRY]->translation_.z = 0.15;
     overlays_[View::GEOMETRY]->visible_ = false;
-    handles_[View::GEOMETRY][Handles::RESIZE] = new Handles(Handles::RESIZE);
-    handles_[View::GEOMETRY][Handles::RESIZE]->color = glm::vec4( COLOR_HIGHLIGHT_SOURCE, 1.f);
-    handles_[View::GEOMETRY][Handles::RESIZE]->translation_.z = 0.1;
-    overlays_[View::GEOMETRY]->attach(handles_[View::GEOMETRY][Handles::RESIZE]);
-    handles_[View::GEOMETRY][Handles::RESIZE_H] = new Handles(Handles::RESIZE_H);
-    handles_[View::GEOMETRY][Handles::RESIZE_H]->color = glm::vec4( COLOR_HIGHLIGHT_SOURCE, 1.f);
-    handles_[View::GEOMETRY][Handles::RESIZE_H]->translation_.z = 0.1;
-    overlays_[View::GEOMETRY]->attach(handles_[View::GEOMETRY][Handles::RESIZE_H]);
-    handles_[View::GEOMETRY][Handles::RESIZE_V] = new Handles(Handles::RESIZE_V);
-    handles_[View::GEOMETRY][Handles::RESIZE_V]->color = glm::vec4( COLOR_HIGHLIGHT_SOURCE, 1.f);
-    handles_[View::GEOMETRY][Handles::RESIZE_V]->translation_.z = 0.1;
-    overlays_[View::GEOMETRY]->attach(handles_[View::GEOMETRY][Handles::RESIZE_V]);
-    handles_[View::GEOMETRY][Handles::ROTATE] = new Handles(Handles::ROTATE);
-    handles_[View::GEOMETRY][Handles::ROTATE]->color = glm::vec4( COLOR_HIGHLIGHT_SOURCE, 1.f);
-    handles_[View::GEOMETRY][Handles::ROTATE]->translation_.z = 0.1;
-    overlays_[View::GEOMETRY]->attach(handles_[View::GEOMETRY][Handles::ROTATE]);
-    handles_[View::GEOMETRY][Handles::SCALE] = new Handles(Handles::SCALE);
-    handles_[View::GEOMETRY][Handles::SCALE]->color = glm::vec4( COLOR_HIGHLIGHT_SOURCE, 1.f);
-    handles_[View::GEOMETRY][Handles::SCALE]->translation_.z = 0.1;
-    overlays_[View::GEOMETRY]->attach(handles_[View::GEOMETRY][Handles::SCALE]);    
-    handles_[View::GEOMETRY][Handles::MENU] = new Handles(Handles::MENU);
-    handles_[View::GEOMETRY][Handles::MENU]->color = glm::vec4( COLOR_HIGHLIGHT_SOURCE, 1.f);
-    handles_[View::GEOMETRY][Handles::MENU]->translation_.z = 0.1;
-    overlays_[View::GEOMETRY]->attach(handles_[View::GEOMETRY][Handles::MENU]);
-
-    frame = new Frame(Frame::SHARP, Frame::THIN, Frame::NONE);
-    frame->translation_.z = 0.1;
-    frame->color = glm::vec4( COLOR_HIGHLIGHT_SOURCE, 0.7f);
-    overlays_[View::GEOMETRY]->attach(frame);
     groups_[View::GEOMETRY]->attach(overlays_[View::GEOMETRY]);
 
     // default layer nodes
@@ -110,14 +72,6 @@ Source::Source() : initialized_(false), active_(true), need_update_(true), symbo
     groups_[View::LAYER]->translation_.z = -1.f;
 
     frames_[View::LAYER] = new Switch;
-    frame = new Frame(Frame::ROUND, Frame::THIN, Frame::PERSPECTIVE);
-    frame->translation_.z = 0.1;
-    frame->color = glm::vec4( COLOR_DEFAULT_SOURCE, 0.8f);    
-    frames_[View::LAYER]->attach(frame);
-    frame = new Frame(Frame::ROUND, Frame::LARGE, Frame::PERSPECTIVE);
-    frame->translation_.z = 0.1;
-    frame->color = glm::vec4( COLOR_HIGHLIGHT_SOURCE, 1.f);
-    frames_[View::LAYER]->attach(frame);
     groups_[View::LAYER]->attach(frames_[View::LAYER]);
 
     overlays_[View::LAYER] = new Group;
@@ -130,43 +84,11 @@ Source::Source() : initialized_(false), active_(true), need_update_(true), symbo
     groups_[View::APPEARANCE]->visible_ = false;
 
     frames_[View::APPEARANCE] = new Switch;
-    frame = new Frame(Frame::SHARP, Frame::THIN, Frame::NONE);
-    frame->translation_.z = 0.1;
-    frame->color = glm::vec4( COLOR_APPEARANCE_SOURCE, 0.7f);
-    frames_[View::APPEARANCE]->attach(frame);
-    frame = new Frame(Frame::SHARP, Frame::LARGE, Frame::NONE);
-    frame->translation_.z = 0.1;
-    frame->color = glm::vec4( COLOR_APPEARANCE_SOURCE, 1.f);
-    frames_[View::APPEARANCE]->attach(frame);
     groups_[View::APPEARANCE]->attach(frames_[View::APPEARANCE]);
 
     overlays_[View::APPEARANCE] = new Group;
     overlays_[View::APPEARANCE]->translation_.z = 0.1;
     overlays_[View::APPEARANCE]->visible_ = false;
-    handles_[View::APPEARANCE][Handles::RESIZE] = new Handles(Handles::RESIZE);
-    handles_[View::APPEARANCE][Handles::RESIZE]->color = glm::vec4( COLOR_APPEARANCE_SOURCE, 1.f);
-    handles_[View::APPEARANCE][Handles::RESIZE]->translation_.z = 0.1;
-    overlays_[View::APPEARANCE]->attach(handles_[View::APPEARANCE][Handles::RESIZE]);
-    handles_[View::APPEARANCE][Handles::RESIZE_H] = new Handles(Handles::RESIZE_H);
-    handles_[View::APPEARANCE][Handles::RESIZE_H]->color = glm::vec4( COLOR_APPEARANCE_SOURCE, 1.f);
-    handles_[View::APPEARANCE][Handles::RESIZE_H]->translation_.z = 0.1;
-    overlays_[View::APPEARANCE]->attach(handles_[View::APPEARANCE][Handles::RESIZE_H]);
-    handles_[View::APPEARANCE][Handles::RESIZE_V] = new Handles(Handles::RESIZE_V);
-    handles_[View::APPEARANCE][Handles::RESIZE_V]->color = glm::vec4( COLOR_APPEARANCE_SOURCE, 1.f);
-    handles_[View::APPEARANCE][Handles::RESIZE_V]->translation_.z = 0.1;
-    overlays_[View::APPEARANCE]->attach(handles_[View::APPEARANCE][Handles::RESIZE_V]);
-    handles_[View::APPEARANCE][Handles::ROTATE] = new Handles(Handles::ROTATE);
-    handles_[View::APPEARANCE][Handles::ROTATE]->color = glm::vec4( COLOR_APPEARANCE_SOURCE, 1.f);
-    handles_[View::APPEARANCE][Handles::ROTATE]->translation_.z = 0.1;
-    overlays_[View::APPEARANCE]->attach(handles_[View::APPEARANCE][Handles::ROTATE]);
-    handles_[View::APPEARANCE][Handles::SCALE] = new Handles(Handles::SCALE);
-    handles_[View::APPEARANCE][Handles::SCALE]->color = glm::vec4( COLOR_APPEARANCE_SOURCE, 1.f);
-    handles_[View::APPEARANCE][Handles::SCALE]->translation_.z = 0.1;
-    overlays_[View::APPEARANCE]->attach(handles_[View::APPEARANCE][Handles::SCALE]);
-    handles_[View::APPEARANCE][Handles::MENU] = new Handles(Handles::MENU);
-    handles_[View::APPEARANCE][Handles::MENU]->color = glm::vec4( COLOR_APPEARANCE_SOURCE, 1.f);
-    handles_[View::APPEARANCE][Handles::MENU]->translation_.z = 0.1;
-    overlays_[View::APPEARANCE]->attach(handles_[View::APPEARANCE][Handles::MENU]);
     groups_[View::APPEARANCE]->attach(overlays_[View::APPEARANCE]);
 
     // empty transition node
@@ -178,6 +100,8 @@ Source::Source() : initialized_(false), active_(true), need_update_(true), symbo
     // those will be associated to nodes later
     blendingshader_ = new ImageShader;
     processingshader_   = new ImageProcessingShader;
+    filter_ = new ImageFilter;
+    effects_ = new EffectChain;
     // default to image processing enabled
     renderingshader_ = (Shader *) processingshader_;
 
@@ -190,6 +114,7 @@ Source::Source() : initialized_(false), active_(true), need_update_(true), symbo
     // will be created at init
     renderbuffer_   = nullptr;
     rendersurface_  = nullptr;
+    mixingsurface_  = nullptr;
 
 }
 
@@ -225,6 +150,90 @@ Source::~Source()
         delete processingshader_;
 
     delete texturesurface_;
+    delete filter_;
+    delete effects_;
+}
+
+void Source::decorate(View::Mode m)
+{
+    if ( m < View::RENDERING || m >= View::INVALID || decorated_[m] )
+        return;
+    decorated_[m] = true;
+
+    Frame *frame = nullptr;
+    glm::vec4 color_handles = glm::vec4( COLOR_HIGHLIGHT_SOURCE, 1.f);
+
+    switch (m) {
+    case View::MIXING:
+    {
+        frame = new Frame(Frame::ROUND, Frame::THIN, Frame::DROP);
+        frame->translation_.z = 0.1;
+        frame->color = glm::vec4( COLOR_DEFAULT_SOURCE, 0.9f);
+        frames_[View::MIXING]->attach(frame);
+        frame = new Frame(Frame::ROUND, Frame::LARGE, Frame::DROP);
+        frame->translation_.z = 0.01;
+        frame->color = glm::vec4( COLOR_HIGHLIGHT_SOURCE, 1.f);
+        frames_[View::MIXING]->attach(frame);
+
+        Symbol *center = new Symbol(Symbol::CIRCLE_POINT, glm::vec3(0.f, 0.f, 0.1f));
+        overlays_[View::MIXING]->attach(center);
+    }
+        break;
+    case View::GEOMETRY:
+        frame = new Frame(Frame::SHARP, Frame::THIN, Frame::NONE);
+        frame->translation_.z = 0.1;
+        frame->color = glm::vec4( COLOR_DEFAULT_SOURCE, 0.7f);
+        frames_[View::GEOMETRY]->attach(frame);
+        frame = new Frame(Frame::SHARP, Frame::LARGE, Frame::GLOW);
+        frame->translation_.z = 0.1;
+        frame->color = glm::vec4( COLOR_HIGHLIGHT_SOURCE, 1.f);
+        frames_[View::GEOMETRY]->attach(frame);
+        break;
+    case View::LAYER:
+        frame = new Frame(Frame::ROUND, Frame::THIN, Frame::PERSPECTIVE);
+        frame->translation_.z = 0.1;
+        frame->color = glm::vec4( COLOR_DEFAULT_SOURCE, 0.8f);
+        frames_[View::LAYER]->attach(frame);
+        frame = new Frame(Frame::ROUND, Frame::LARGE, Frame::PERSPECTIVE);
+        frame->translation_.z = 0.1;
+        frame->color = glm::vec4( COLOR_HIGHLIGHT_SOURCE, 1.f);
+        frames_[View::LAYER]->attach(frame);
+        break;
+    case View::APPEARANCE:
+        frame = new Frame(Frame::SHARP, Frame::THIN, Frame::NONE);
+        frame->translation_.z = 0.1;
+        frame->color = glm::vec4( COLOR_APPEARANCE_SOURCE, 0.7f);
+        frames_[View::APPEARANCE]->attach(frame);
+        frame = new Frame(Frame::SHARP, Frame::LARGE, Frame::NONE);
+        frame->translation_.z = 0.1;
+        frame->color = glm::vec4( COLOR_APPEARANCE_SOURCE, 1.f);
+        frames_[View::APPEARANCE]->attach(frame);
+        color_handles = glm::vec4( COLOR_APPEARANCE_SOURCE, 1.f);
+        break;
+    default:
+        break;
+    }
+
+    // handles to manipulate the current source
+    if ( m == View::GEOMETRY || m == View::APPEARANCE ) {
+        for (int h = Handles::RESIZE; h <= Handles::MENU; h++) {
+            handles_[m][h] = new Handles( (Handles::Type) h );
+            handles_[m][h]->color = color_handles;
+            handles_[m][h]->translation_.z = 0.1;
+            overlays_[m]->attach(handles_[m][h]);
+        }
+    }
+
+    if ( m == View::GEOMETRY ) {
+        frame = new Frame(Frame::SHARP, Frame::THIN, Frame::NONE);
+        frame->translation_.z = 0.1;
+        frame->color = glm::vec4( COLOR_HIGHLIGHT_SOURCE, 0.7f);
+        overlays_[View::GEOMETRY]->attach(frame);
+    }
+
+    // choose frame as in setMode
+    if ( frames_.count(m) > 0 )
+        frames_[m]->setActive( mode_ == Source::VISIBLE ? 0 : 1 );
 }
 
 void Source::setName (const std::string &name)
@@ -312,16 +321,51 @@ void Source::render()
         init();
     else {
         // render the view into frame buffer
-        renderbuffer_->begin();
-        texturesurface_->draw(glm::identity<glm::mat4>(), renderbuffer_->projection());
-        renderbuffer_->end();
+        renderTexture();
     }
 }
 
+void Source::renderTexture()
+{
+    uint texture = texturesurface_->textureIndex();
+    uint input = texture;
+    glm::ivec2 resolution(renderbuffer_->width(), renderbuffer_->height());
+
+    // filters done in multiple passes are applied before the processing shader
+    if ( imageProcessingEnabled() && ImageProcessingShader::multipass(processingshader_->filterid) )
+        input = filter_->apply(input, processingshader_->filterid, resolution);
+    else
+        filter_->release();
+
+    // then the effects
+    input = effects_->apply(input, resolution);
+
+    texturesurface_->setTextureIndex(input);
+
+    renderbuffer_->begin();
+    texturesurface_->draw(glm::identity<glm::mat4>(), renderbuffer_->projection());
+    renderbuffer_->end();
+
+    texturesurface_->setTextureIndex(texture);
+}
+
+
+void Source::evaluateConsumed()
+{
+    // visible in the rendering of the session or inspected by user
+    consumed_ = ( active_ && blendingshader_->color.a > EPSILON ) || mode_ == Source::CURRENT;
+
+    // needed by a clone
+    for (auto clone = clones_.begin(); clone != clones_.end() && !consumed_; clone++)
+        consumed_ = (*clone)->consumed();
+}
+
 
 void Source::attach(FrameBuffer *renderbuffer)
 {
     renderbuffer_ = renderbuffer;
+    resolution_ = renderbuffer_->resolution();
+    lod_ = 0;
 
     // if a symbol is available, add it to icons
     if (symbol_) {
@@ -338,11 +382,11 @@ void Source::attach(FrameBuffer *renderbuffer)
 
     // for mixing and layer views, add another surface to overlay
     // (stippled view on top with transparency)
-    Surface *surfacemix = new FrameBufferSurface(renderbuffer_);
-    ImageShader *is = static_cast<ImageShader *>(surfacemix->shader());
+    mixingsurface_ = new FrameBufferSurface(renderbuffer_);
+    ImageShader *is = static_cast<ImageShader *>(mixingsurface_->shader());
     if (is)  is->stipple = 1.0;
-    groups_[View::MIXING]->attach(surfacemix);
-    groups_[View::LAYER]->attach(surfacemix);
+    groups_[View::MIXING]->attach(mixingsurface_);
+    groups_[View::LAYER]->attach(mixingsurface_);
 
     // for appearance view, a dedicated surface without blending
     Surface *surfacetmp = new Surface();
@@ -352,7 +396,7 @@ void Source::attach(FrameBuffer *renderbuffer)
     // Transition group node is optionnal
     if ( groups_[View::TRANSITION]->numChildren() > 0 ) {
         groups_[View::TRANSITION]->attach(rendersurface_);
-        groups_[View::TRANSITION]->attach(surfacemix);
+        groups_[View::TRANSITION]->attach(mixingsurface_);
     }
 
     // scale all icon nodes to match aspect ratio
@@ -368,6 +412,10 @@ void Source::attach(FrameBuffer *renderbuffer)
     if ( mode_ == UNINITIALIZED ) {
         setMode(VISIBLE);
         need_update_ = true;
+
+        std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - creation_time_;
+        load_time_ = elapsed.count();
+        Log::Info("Source '%s' loaded in %.0f ms.", name().c_str(), load_time_);
     }
 }
 
@@ -479,6 +527,46 @@ FrameBuffer *Source::frame() const
     }
 }
 
+size_t Source::memory() const
+{
+    return (renderbuffer_ ? renderbuffer_->memory() : 0) + filter_->memory() + effects_->memory();
+}
+
+uint Source::computeLod(glm::vec3 output) const
+{
+    if ( !Settings::application.render.lod || output.y < 1.f )
+        return 0;
+
+    // The height of the output is 2 in the RENDERING view, as is the height
+    // of a source of scale 1 (its width is scaled by its aspect ratio).
+    // The number of lines of the source displayed in the output is thus
+    // the height of the output multiplied by the largest scale.
+    glm::vec3 s = groups_[View::RENDERING]->scale_;
+    float displayed = output.y * MAXI( ABS(s.x), ABS(s.y) );
+
+    // halve resolution as long as it remains above displayed resolution
+    uint l = 0;
+    while ( l < MAX_SOURCE_LOD && resolution_.y / float(1 << (l + 1)) >= displayed )
+        ++l;
+
+    return l;
+}
+
+bool Source::updateLod(glm::vec3 output)
+{
+    if ( !initialized_ || renderbuffer_ == nullptr )
+        return false;
+
+    uint l = computeLod(output);
+    if ( l == lod_ )
+        return false;
+
+    lod_ = l;
+    renderbuffer_->resize( resolution_ / float(1 << lod_) );
+
+    return true;
+}
+
 bool Source::contains(Node *node) const
 {
     if ( node == nullptr )
@@ -526,7 +614,7 @@ CloneSource *Source::clone()
 }
 
 
-CloneSource::CloneSource(Source *origin) : Source(), origin_(origin)
+CloneSource::CloneSource(Source *origin) : Source(), origin_(origin), provider_(nullptr), ownbuffer_(nullptr)
 {
     // set symbol
     symbol_ = new Symbol(Symbol::CLONE, glm::vec3(0.8f, 0.8f, 0.01f));
@@ -534,8 +622,18 @@ CloneSource::CloneSource(Source *origin) : Source(), origin_(origin)
 
 CloneSource::~CloneSource()
 {
-    if (origin_)
+    if (origin_) {
         origin_->clones_.remove(this);
+        // other clones displaying our renderbuffer shall render their own
+        if (provider_ == nullptr) {
+            for (auto it = origin_->clones_.begin(); it != origin_->clones_.end(); it++)
+                if ( (*it)->provider_ == this )
+                    (*it)->link(nullptr);
+        }
+    }
+
+    // only the renderbuffer of the clone is deleted in ~Source
+    renderbuffer_ = ownbuffer_;
 }
 
 CloneSource *CloneSource::clone()
@@ -547,6 +645,103 @@ CloneSource *CloneSource::clone()
         return nullptr;
 }
 
+SourceList CloneSource::dependencies() const
+{
+    SourceList deps;
+    if (origin_)
+        deps.push_back(origin_);
+    return deps;
+}
+
+void CloneSource::detach()
+{
+    // stop displaying the renderbuffer of a provider
+    // (called by the origin before deleting its renderbuffer)
+    if (provider_)
+        link(nullptr);
+
+    origin_ = nullptr;
+}
+
+bool CloneSource::rendersLike(const Source *s) const
+{
+    // the source shall be rendered at this frame, at least as detailed,
+    // and with the same crop of the same texture
+    if ( !s->ready() || !s->consumed() || s->lod_ > lod_ || s->texturesurface_->scale_ != texturesurface_->scale_)
+        return false;
+
+    // with the same effects
+    if ( !(*s->effects_ == *effects_) )
+        return false;
+
+    // and with the same shader and parameters
+    ImageProcessingShader *ps = dynamic_cast<ImageProcessingShader *>(s->renderingshader_);
+    ImageProcessingShader *p = dynamic_cast<ImageProcessingShader *>(renderingshader_);
+    if ( ps && p )
+        return *ps == *p;
+
+    ImageShader *is = dynamic_cast<ImageShader *>(s->renderingshader_);
+    ImageShader *i = dynamic_cast<ImageShader *>(renderingshader_);
+    if ( is && i )
+        return *is == *i;
+
+    return false;
+}
+
+Source *CloneSource::findProvider() const
+{
+    if (origin_ == nullptr)
+        return nullptr;
+
+    // same rendering as the origin
+    if ( rendersLike(origin_) )
+        return origin_;
+
+    // same rendering as another clone which renders its own renderbuffer
+    for (auto it = origin_->clones_.begin(); it != origin_->clones_.end(); it++) {
+        if ( *it != this && (*it)->provider_ == nullptr && (*it)->ownbuffer_ && rendersLike(*it) )
+            return *it;
+    }
+
+    return nullptr;
+}
+
+void CloneSource::link(Source *provider)
+{
+    if ( provider == provider_ && renderbuffer_ != nullptr )
+        return;
+
+    // other clones displaying our renderbuffer shall render their own
+    if (provider_ == nullptr && origin_ != nullptr) {
+        for (auto it = origin_->clones_.begin(); it != origin_->clones_.end(); it++)
+            if ( *it != this && (*it)->provider_ == this )
+                (*it)->link(nullptr);
+    }
+
+    provider_ = provider;
+
+    if (provider_) {
+        // display the renderbuffer of the provider, free ours
+        renderbuffer_ = provider_->renderbuffer_;
+        if (ownbuffer_) {
+            delete ownbuffer_;
+            ownbuffer_ = nullptr;
+        }
+    }
+    else {
+        // create Frame buffer matching size of origin, at our level of detail
+        if (ownbuffer_ == nullptr)
+            ownbuffer_ = new FrameBuffer( origin_->resolution_ / float(1 << lod_), true);
+        renderbuffer_ = ownbuffer_;
+    }
+
+    // surfaces are created at attach()
+    if (rendersurface_)
+        rendersurface_->setFrameBuffer(renderbuffer_);
+    if (mixingsurface_)
+        mixingsurface_->setFrameBuffer(renderbuffer_);
+}
+
 void CloneSource::init()
 {
     if (origin_ && origin_->ready()) {
@@ -554,11 +749,12 @@ void CloneSource::init()
         // get the texture index from framebuffer of view, apply it to the surface
         texturesurface_->setTextureIndex( origin_->texture() );
 
-        // create Frame buffer matching size of session
-        FrameBuffer *renderbuffer = new FrameBuffer( origin_->frame()->resolution(), true);
+        // use the renderbuffer of a provider, or create one matching size of origin
+        link( findProvider() );
 
         // set the renderbuffer of the source and attach rendering nodes
-        attach(renderbuffer);
+        attach(renderbuffer_);
+        resolution_ = origin_->resolution_;
 
         // done init
         initialized_ = true;
@@ -567,6 +763,19 @@ void CloneSource::init()
     }
 }
 
+void CloneSource::render()
+{
+    if (!initialized_)
+        init();
+    else {
+        // no need to render an image identical to the one of a provider
+        link( findProvider() );
+
+        if (provider_ == nullptr)
+            Source::render();
+    }
+}
+
 void CloneSource::setActive (bool on)
 {
     active_ = on;
@@ -588,6 +797,29 @@ uint CloneSource::texture() const
         return Resource::getTextureBlack();
 }
 
+bool CloneSource::updateLod(glm::vec3 output)
+{
+    if ( !initialized_ || origin_ == nullptr )
+        return false;
+
+    uint l = computeLod(output);
+    if ( l == lod_ )
+        return false;
+
+    lod_ = l;
+    // never resize the renderbuffer of a provider
+    if (ownbuffer_)
+        ownbuffer_->resize( resolution_ / float(1 << lod_) );
+
+    return true;
+}
+
+size_t CloneSource::memory() const
+{
+    // the renderbuffer of a provider is not counted
+    return (ownbuffer_ ? ownbuffer_->memory() : 0) + filter_->memory() + effects_->memory();
+}
+
 void CloneSource::accept(Visitor& v)
 {
     Source::accept(v);
@@ -5,6 +5,7 @@
 #include <map>
 #include <atomic>
 #include <list>
+#include <chrono>
 
 #include "View.h"
 
@@ -59,6 +60,10 @@ public:
     Mode mode () const;
     void setMode (Mode m);
 
+    // create the frames, handles and icons displayed in a view
+    // (done only once, when the view first displays the source)
+    void decorate (View::Mode m);
+
     // get handle on the nodes used to manipulate the source in a view
     inline Group *group (View::Mode m) const { return groups_.at(m); }
     inline Node  *groupNode (View::Mode m) const { return static_cast<Node*>(groups_.at(m)); }
@@ -75,6 +80,9 @@ public:
     // the rendering shader always have an image processing shader
     inline ImageProcessingShader *processingShader () const { return processingshader_; }
 
+    // Effects : chain of passes rendered before the image processing
+    inline class EffectChain *effects () const { return effects_; }
+
     // the image processing shader can be enabled or disabled
     // (NB: when disabled, a simple ImageShader is applied)
     void setImageProcessingEnabled (bool on);
@@ -86,12 +94,25 @@ public:
     // every Source has a frame buffer from the renderbuffer
     virtual FrameBuffer *frame () const;
 
+    // GPU memory used by the source (textures and buffers)
+    virtual size_t memory () const;
+
+    // level of detail: the renderbuffer has 1/2^lod of the resolution of
+    // the source when it is displayed smaller in the output of the session
+    // (automatic if Settings::application.render.lod, disabled otherwise)
+    // returns true if the resolution of the renderbuffer changed
+    virtual bool updateLod (glm::vec3 output);
+    inline uint lod () const { return lod_; }
+
     // touch to request update
     inline void touch () { need_update_ = true; }
 
     // informs if its ready (i.e. initialized)
     inline bool ready () const  { return initialized_; }
 
+    // time (ms) from creation of the source until it was ready
+    inline float loadTime () const { return load_time_; }
+
     // a Source shall be updated before displayed (Mixing, Geometry and Layer)
     virtual void update (float dt);
 
@@ -108,6 +129,16 @@ public:
     // a Source shall define how to render into the frame buffer
     virtual void render ();
 
+    // render graph: sources which shall be updated before this one
+    // (e.g. the origin of a clone)
+    virtual SourceList dependencies () const { return SourceList(); }
+
+    // render graph: the output is used at this frame if the source is
+    // visible in the session, is current, or is the origin of a used clone
+    // NB: shall be evaluated after all the clones (consumers) of the source
+    void evaluateConsumed ();
+    inline bool consumed () const { return consumed_; }
+
     // accept all kind of visitors
     virtual void accept (Visitor& v);
 
@@ -150,6 +181,8 @@ protected:
     // every Source shall be initialized on first draw
     bool initialized_;
     virtual void init() = 0;
+    std::chrono::high_resolution_clock::time_point creation_time_;
+    float load_time_;
 
     // nodes
     std::map<View::Mode, Group*> groups_;
@@ -158,13 +191,25 @@ protected:
     // NB: rendershader_ is applied at render()
     FrameBuffer *renderbuffer_;
     void attach(FrameBuffer *renderbuffer);
+    // draw the texturesurface in the renderbuffer (after multi-pass filter and effects)
+    void renderTexture();
+
+    // resolution of the renderbuffer at attach, and level of detail
+    glm::vec3 resolution_;
+    uint lod_;
+    uint computeLod (glm::vec3 output) const;
 
     // the rendersurface draws the renderbuffer in the scene
     // It is associated to the rendershader for mixing effects
     FrameBufferSurface *rendersurface_;
+    // the mixingsurface draws the renderbuffer in overlay (stippled)
+    FrameBufferSurface *mixingsurface_;
 
     // image processing shaders
     ImageProcessingShader *processingshader_;
+    // multi-pass filters of the processing shader
+    class ImageFilter *filter_;
+    class EffectChain *effects_;
     // pointer to the currently attached shader
     // (will be processingshader_ if image processing is enabled)
     Shader *renderingshader_;
@@ -183,9 +228,11 @@ protected:
     std::map<View::Mode, Switch*> frames_;
     std::map<View::Mode, Handles*[6]> handles_;
     Symbol *symbol_;
+    bool decorated_[View::INVALID];
 
     // update
     bool  active_;
+    bool  consumed_;
     bool  need_update_;
     float dt_;
     Group *stored_status_;
@@ -206,11 +253,16 @@ public:
     // implementation of source API
     void setActive (bool on) override;
     uint texture() const override;
+    size_t memory() const override;
+    bool updateLod (glm::vec3 output) override;
     bool failed() const override  { return origin_ == nullptr; }
     void accept (Visitor& v) override;
 
+    void render() override;
+
     CloneSource *clone() override;
-    inline void detach() { origin_ = nullptr; }
+    SourceList dependencies () const override;
+    void detach();
     inline Source *origin() const { return origin_; }
 
     glm::ivec2 icon() const override { return glm::ivec2(9, 2); }
@@ -221,6 +273,15 @@ protected:
 
     void init() override;
     Source *origin_;
+
+    // A clone rendering the same image as its origin, or as another
+    // clone of the same origin, displays the renderbuffer of this
+    // provider instead of rendering (and allocating) its own.
+    Source *provider_;
+    FrameBuffer *ownbuffer_;
+    bool rendersLike(const Source *s) const;
+    Source *findProvider() const;
+    void link(Source *provider);
 };
 
 
@@ -13,6 +13,7 @@ using namespace std;
 #include "Visitor.h"
 #include "SystemToolkit.h"
 #include "GlmToolkit.h"
+#include "GpuPool.h"
 
 #include "Stream.h"
 
@@ -30,6 +31,7 @@ Stream::Stream()
 
     description_ = "undefined";
     pipeline_ = nullptr;
+    guard_ = nullptr;
 
     width_ = -1;
     height_ = -1;
@@ -137,6 +139,9 @@ void Stream::execute_open()
     gst_app_sink_set_max_buffers( GST_APP_SINK(sink), 30);
     gst_app_sink_set_drop (GST_APP_SINK(sink), true);
 
+    // callbacks are given a guard of this stream (see close)
+    guard_ = new GstToolkit::CallbackGuard(this);
+
 #ifdef USE_GST_APPSINK_CALLBACKS_
     // set the callbacks
     GstAppSinkCallbacks callbacks;
@@ -151,14 +156,14 @@ void Stream::execute_open()
         callbacks.eos = callback_end_of_stream;
         callbacks.new_sample = callback_new_sample;
     }
-    gst_app_sink_set_callbacks (GST_APP_SINK(sink), &callbacks, this, NULL);
+    gst_app_sink_set_callbacks (GST_APP_SINK(sink), &callbacks, guard_, NULL);
     gst_app_sink_set_emit_signals (GST_APP_SINK(sink), false);
 #else
     // connect signals callbacks
-    g_signal_connect(G_OBJECT(sink), "new-preroll", G_CALLBACK (callback_new_preroll), this);
+    g_signal_connect(G_OBJECT(sink), "new-preroll", G_CALLBACK (callback_new_preroll), guard_);
     if (!single_frame_) {
-        g_signal_connect(G_OBJECT(sink), "new-sample", G_CALLBACK (callback_new_sample), this);
-        g_signal_connect(G_OBJECT(sink), "eos", G_CALLBACK (callback_end_of_stream), this);
+        g_signal_connect(G_OBJECT(sink), "new-sample", G_CALLBACK (callback_new_sample), guard_);
+        g_signal_connect(G_OBJECT(sink), "eos", G_CALLBACK (callback_end_of_stream), guard_);
     }
     gst_app_sink_set_emit_signals (GST_APP_SINK(sink), true);
 #endif
@@ -208,16 +213,10 @@ void Stream::close()
     // un-ready
     ready_ = false;
 
-    // clean up GST
-    if (pipeline_ != nullptr) {
-        GstStateChangeReturn ret = gst_element_set_state (pipeline_, GST_STATE_NULL);
-        if (ret == GST_STATE_CHANGE_ASYNC) {
-            GstState state;
-            gst_element_get_state (pipeline_, &state, NULL, GST_CLOCK_TIME_NONE);
-        }
-        gst_object_unref (pipeline_);
-        pipeline_ = nullptr;
-    }
+    // clean up GST : detach callbacks and stop pipeline in background
+    GstToolkit::pipeline_teardown(pipeline_, guard_);
+    pipeline_ = nullptr;
+    guard_ = nullptr;
     desired_state_ = GST_STATE_PAUSED;
 
     // cleanup eventual remaining frame memory
@@ -230,14 +229,13 @@ void Stream::close()
     write_index_ = 0;
     last_index_ = 0;
 
-    // cleanup opengl texture
+    // give back opengl texture
     if (textureindex_)
-        glDeleteTextures(1, &textureindex_);
+        GpuPool::manager().releaseTexture(textureindex_);
     textureindex_ = 0;
 
-    // cleanup picture buffer
-    if (pbo_[0])
-        glDeleteBuffers(2, pbo_);
+    // give back picture buffers
+    release_pbo();
     pbo_size_ = 0;
 }
 
@@ -355,32 +353,40 @@ bool Stream::isPlaying(bool testpipeline) const
 
 
 
+void Stream::release_pbo()
+{
+    for(int i = 0; i < 2; i++ ) {
+        if (pbo_[i])
+            GpuPool::manager().releaseBuffer(pbo_[i]);
+        pbo_[i] = 0;
+    }
+}
+
+size_t Stream::memory() const
+{
+    return GpuPool::manager().textureMemory(textureindex_) +
+            GpuPool::manager().bufferMemory(pbo_[0]) + GpuPool::manager().bufferMemory(pbo_[1]);
+}
+
 void Stream::init_texture(guint index)
 {
     glActiveTexture(GL_TEXTURE0);
-    glGenTextures(1, &textureindex_);
+    textureindex_ = GpuPool::manager().acquireTexture(width_, height_, GL_RGBA8);
     glBindTexture(GL_TEXTURE_2D, textureindex_);
-    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width_, height_);
     glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_,
                     GL_RGBA, GL_UNSIGNED_BYTE, frame_[index].vframe.data[0]);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
     // set pbo image size
     pbo_size_ = height_ * width_ * 4;
 
-    // create pixel buffer objects,
-    if (pbo_[0])
-        glDeleteBuffers(2, pbo_);
-    glGenBuffers(2, pbo_);
+    // get pixel buffer objects from the pool
+    release_pbo();
+    pbo_[0] = GpuPool::manager().acquireBuffer(pbo_size_, GL_STREAM_DRAW);
+    pbo_[1] = GpuPool::manager().acquireBuffer(pbo_size_, GL_STREAM_DRAW);
 
     for(int i = 0; i < 2; i++ ) {
-        // create 2 PBOs
+        // 2 PBOs with reserved memory space
         glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_[i]);
-        // glBufferDataARB with NULL pointer reserves only memory space.
-        glBufferData(GL_PIXEL_UNPACK_BUFFER, pbo_size_, 0, GL_STREAM_DRAW);
         // fill in with reset picture
         GLubyte* ptr = (GLubyte*) glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
         if (ptr)  {
@@ -391,8 +397,7 @@ void Stream::init_texture(guint index)
         }
         else {
             // did not work, disable PBO
-            glDeleteBuffers(2, pbo_);
-            pbo_[0] = pbo_[1] = 0;
+            release_pbo();
             pbo_size_ = 0;
             break;
         }
@@ -532,6 +537,23 @@ double Stream::updateFrameRate() const
     return timecount_.frameRate();
 }
 
+GstClockTime Stream::latency() const
+{
+    GstClockTime min_latency = GST_CLOCK_TIME_NONE;
+
+    if (ready_ && pipeline_ != nullptr) {
+        GstQuery *query = gst_query_new_latency ();
+        if ( gst_element_query (pipeline_, query) ) {
+            gboolean live = FALSE;
+            GstClockTime max_latency = 0;
+            gst_query_parse_latency (query, &live, &min_latency, &max_latency);
+        }
+        gst_query_unref (query);
+    }
+
+    return min_latency;
+}
+
 
 // CALLBACKS
 
@@ -615,7 +637,9 @@ bool Stream::fill_frame(GstBuffer *buf, FrameStatus status)
 
 void Stream::callback_end_of_stream (GstAppSink *, gpointer p)
 {
-    Stream *m = (Stream *)p;
+    GstToolkit::CallbackGuard *guard = (GstToolkit::CallbackGuard *)p;
+    std::lock_guard<std::mutex> lock(guard->lock);
+    Stream *m = (Stream *)guard->owner;
     if (m && m->ready_) {
         m->fill_frame(NULL, Stream::EOS);
     }
@@ -630,8 +654,10 @@ GstFlowReturn Stream::callback_new_preroll (GstAppSink *sink, gpointer p)
 
     // if got a valid sample
     if (sample != NULL) {
-        // send frames to media player only if ready
-        Stream *m = (Stream *)p;
+        // send frames to media player only if ready (and not closed)
+        GstToolkit::CallbackGuard *guard = (GstToolkit::CallbackGuard *)p;
+        std::lock_guard<std::mutex> lock(guard->lock);
+        Stream *m = (Stream *)guard->owner;
         if (m && m->ready_) {
 
             // get buffer from sample
@@ -664,8 +690,10 @@ GstFlowReturn Stream::callback_new_sample (GstAppSink *sink, gpointer p)
     // if got a valid sample
     if (sample != NULL && !gst_app_sink_is_eos (sink)) {
 
-        // send frames to media player only if ready
-        Stream *m = (Stream *)p;
+        // send frames to media player only if ready (and not closed)
+        GstToolkit::CallbackGuard *guard = (GstToolkit::CallbackGuard *)p;
+        std::lock_guard<std::mutex> lock(guard->lock);
+        Stream *m = (Stream *)guard->owner;
         if (m && m->ready_) {
 
             // get buffer from sample (valid until sample is released)
@@ -10,6 +10,8 @@
 #include <gst/pbutils/pbutils.h>
 #include <gst/app/gstappsink.h>
 
+#include "GstToolkit.h"
+
 // Forward declare classes referenced
 class Visitor;
 
@@ -88,6 +90,11 @@ public:
      * measured during play
      * */
     double updateFrameRate() const;
+    /**
+     * Get latency of the pipeline
+     * as reported by live elements (e.g. network jitter buffers)
+     * */
+    GstClockTime latency() const;
     /**
      * Get frame width
      * */
@@ -106,6 +113,11 @@ public:
      * Must be called in OpenGL context
      * */
     guint texture() const;
+    /**
+     * Get the GPU memory used for texturing
+     * (texture and pixel buffer objects)
+     * */
+    size_t memory() const;
     /**
      * Accept visitors
      * Used for saving session file
@@ -128,6 +140,7 @@ protected:
     // GST & Play status
     GstState desired_state_;
     GstElement *pipeline_;
+    GstToolkit::CallbackGuard *guard_;
     GstVideoInfo v_frame_video_info_;
     std::atomic<bool> ready_;
     std::atomic<bool> failed_;
@@ -185,6 +198,7 @@ protected:
 
     // gst frame filling
     void init_texture(guint index);
+    void release_pbo();
     void fill_texture(guint index);
     bool fill_frame(GstBuffer *buf, FrameStatus status);
 
@@ -60,6 +60,13 @@ uint StreamSource::texture() const
         return stream_->texture();
 }
 
+size_t StreamSource::memory() const
+{
+    if (stream_ == nullptr)
+        return Source::memory();
+    return Source::memory() + stream_->memory();
+}
+
 void StreamSource::init()
 {
     if ( stream_ && stream_->isOpen() ) {
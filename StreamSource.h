@@ -32,6 +32,7 @@ public:
     void setActive (bool on) override;
     bool failed() const override;
     uint texture() const override;
+    size_t memory() const override;
 
     // pure virtual interface
     virtual Stream *stream() const = 0;
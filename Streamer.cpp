@@ -25,6 +25,7 @@
 
 #include "Connection.h"
 #include "NetworkToolkit.h"
+#include "Stream.h"
 #include "Streamer.h"
 
 #include <iostream>
@@ -78,7 +79,8 @@ void wait_for_request_(UdpListeningReceiveSocket *receiver)
     receiver->Run();
 }
 
-Streaming::Streaming() : enabled_(false)
+Streaming::Streaming() : enabled_(false), test_streamer_(0), test_receiver_(nullptr),
+    test_relay_(nullptr), test_protocol_(NetworkToolkit::DEFAULT)
 {
     int port = Connection::manager().info().port_stream_request;
     receiver_ = new UdpListeningReceiveSocket(IpEndpointName( IpEndpointName::ANY_ADDRESS, port ), &listener_ );
@@ -88,12 +90,113 @@ Streaming::Streaming() : enabled_(false)
 
 Streaming::~Streaming()
 {
+    stopTest();
+
     if (receiver_!=nullptr) {
         receiver_->Break();
         delete receiver_;
     }
 }
 
+bool Streaming::available(NetworkToolkit::Protocol p)
+{
+    if (p < 0 || p >= NetworkToolkit::DEFAULT)
+        return false;
+
+    // check the presence of every element of the protocol
+    std::istringstream elements(NetworkToolkit::protocol_elements[p]);
+    std::string e;
+    while (elements >> e) {
+        if ( !GstToolkit::has_feature(e) )
+            return false;
+    }
+
+    return true;
+}
+
+void Streaming::startTest(NetworkToolkit::Protocol p, float loss)
+{
+    // start fresh
+    stopTest();
+
+    // only datagram protocols can go through the lossy relay
+    if (p != NetworkToolkit::UDP_JPEG && p != NetworkToolkit::UDP_H264 && p != NetworkToolkit::SRT_H264) {
+        Log::Warning("Cannot test %s on loopback.", NetworkToolkit::protocol_name[p]);
+        return;
+    }
+    if ( !available(p) ) {
+        Log::Warning("Cannot test %s: missing GStreamer plugins.", NetworkToolkit::protocol_name[p]);
+        return;
+    }
+    if ( FrameGrabbing::manager().width() < 1 ) {
+        Log::Warning("Cannot test %s: no output frame to stream.", NetworkToolkit::protocol_name[p]);
+        return;
+    }
+
+    // relay listens on test port and forwards to the next port
+    int relay_port = LOOPBACK_TEST_PORT;
+    int end_port = LOOPBACK_TEST_PORT + 1;
+    test_relay_ = new NetworkToolkit::LossyRelay(relay_port, end_port);
+    test_relay_->setLoss(loss);
+    if ( !test_relay_->start() ) {
+        Log::Warning("Cannot test %s: port %d unavailable.", NetworkToolkit::protocol_name[p], relay_port);
+        delete test_relay_;
+        test_relay_ = nullptr;
+        return;
+    }
+
+    // the streamer sends to the relay (UDP) or listens after the relay (SRT)
+    NetworkToolkit::StreamConfig conf;
+    conf.protocol = p;
+    conf.client_name = "loopback test";
+    conf.client_address = "127.0.0.1";
+    conf.port = (p == NetworkToolkit::SRT_H264) ? end_port : relay_port;
+    conf.width = FrameGrabbing::manager().width();
+    conf.height = FrameGrabbing::manager().height();
+    VideoStreamer *streamer = new VideoStreamer(conf);
+    test_streamer_ = streamer->id();
+    FrameGrabbing::manager().add(streamer);
+
+    // the receiver listens after the relay (UDP) or calls the relay (SRT)
+    std::string parameter = (p == NetworkToolkit::SRT_H264) ?
+                conf.client_address + ":" + std::to_string(relay_port) : std::to_string(end_port);
+    std::string pipeline = NetworkToolkit::protocol_receive_pipeline[p];
+    pipeline.replace(pipeline.find("XXXX"), 4, parameter);
+    pipeline += " ! videoconvert";
+
+    test_receiver_ = new Stream;
+    test_receiver_->open(pipeline, conf.width, conf.height);
+    test_receiver_->play(true);
+    test_protocol_ = p;
+
+    Log::Info("Testing %s on loopback with %.0f%% packet loss.", NetworkToolkit::protocol_name[p], loss * 100.f);
+}
+
+void Streaming::stopTest()
+{
+    FrameGrabber *streamer = FrameGrabbing::manager().get(test_streamer_);
+    if (streamer)
+        streamer->stop();
+    test_streamer_ = 0;
+
+    if (test_receiver_) {
+        delete test_receiver_;
+        test_receiver_ = nullptr;
+    }
+
+    if (test_relay_) {
+        delete test_relay_;
+        test_relay_ = nullptr;
+    }
+
+    test_protocol_ = NetworkToolkit::DEFAULT;
+}
+
+bool Streaming::testing()
+{
+    return test_receiver_ != nullptr && FrameGrabbing::manager().get(test_streamer_) != nullptr;
+}
+
 bool Streaming::busy()
 {
     bool b = false;
@@ -232,6 +335,9 @@ void Streaming::addStream(const std::string &sender, int reply_to, const std::st
     //        conf.protocol = NetworkToolkit::SHM_RAW;
     //    //  any other IP : offer network streaming
     //    else
+    // offer the protocol selected by user, if it can be used
+    conf.protocol = (NetworkToolkit::Protocol) Settings::application.stream.protocol;
+    if ( conf.protocol == NetworkToolkit::SHM_RAW || !available(conf.protocol) )
         conf.protocol = NetworkToolkit::UDP_JPEG;
 
     // build OSC message
@@ -317,6 +423,12 @@ void VideoStreamer::init(GstCaps *caps)
         g_object_set (G_OBJECT (gst_bin_get_by_name (GST_BIN (pipeline_), "sink")),
                       "socket-path", path.c_str(),  NULL);
     }
+    else if (config_.protocol == NetworkToolkit::SRT_H264) {
+        // SRT listener on the port: the client calls to receive the stream
+        std::string uri = "srt://:" + std::to_string(config_.port) + "?mode=listener";
+        g_object_set (G_OBJECT (gst_bin_get_by_name (GST_BIN (pipeline_), "sink")),
+                      "uri", uri.c_str(),  NULL);
+    }
 
     // setup custom app source
     src_ = GST_APP_SRC( gst_bin_get_by_name (GST_BIN (pipeline_), "src") );
@@ -14,6 +14,7 @@
 #include "FrameGrabber.h"
 
 class Session;
+class Stream;
 class VideoStreamer;
 
 class StreamingRequestListener : public osc::OscPacketListener {
@@ -50,6 +51,17 @@ public:
     bool busy();
     std::vector<std::string> listStreams();
 
+    // true if the gstreamer elements for this protocol are installed
+    static bool available(NetworkToolkit::Protocol p);
+
+    // loopback test: stream to ourself through a lossy relay on localhost
+    void startTest(NetworkToolkit::Protocol p, float loss);
+    void stopTest();
+    bool testing();
+    inline Stream *testStream() const { return test_receiver_; }
+    inline NetworkToolkit::LossyRelay *testRelay() const { return test_relay_; }
+    inline NetworkToolkit::Protocol testProtocol() const { return test_protocol_; }
+
 protected:
     void addStream(const std::string &sender, int reply_to, const std::string &clientname);
     void refuseStream(const std::string &sender, int reply_to);
@@ -62,6 +74,12 @@ private:
 
     std::vector<VideoStreamer *> streamers_;    
     std::mutex streamers_lock_;
+
+    // loopback test
+    uint64_t test_streamer_;
+    Stream *test_receiver_;
+    NetworkToolkit::LossyRelay *test_relay_;
+    NetworkToolkit::Protocol test_protocol_;
 };
 
 class VideoStreamer : public FrameGrabber
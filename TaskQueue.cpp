@@ -0,0 +1,57 @@
+#include <chrono>
+
+#include "defines.h"
+
+#include "TaskQueue.h"
+
+
+TaskQueue::TaskQueue() : overruns_(0), time_(0.f)
+{
+
+}
+
+float TaskQueue::budget()
+{
+    return TASK_QUEUE_BUDGET;
+}
+
+void TaskQueue::push(std::function<void()> task)
+{
+    std::lock_guard<std::mutex> lock(access_);
+    tasks_.push_back(task);
+}
+
+size_t TaskQueue::depth()
+{
+    std::lock_guard<std::mutex> lock(access_);
+    return tasks_.size();
+}
+
+void TaskQueue::run()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<float, std::milli> elapsed(0.f);
+
+    // only the tasks pending when starting (tasks can push tasks)
+    access_.lock();
+    size_t count = tasks_.size();
+    access_.unlock();
+
+    for (size_t i = 0; i < count && elapsed.count() < budget(); ++i) {
+
+        // take next task
+        access_.lock();
+        std::function<void()> task = tasks_.front();
+        tasks_.pop_front();
+        access_.unlock();
+
+        // execute unlocked
+        task();
+
+        elapsed = std::chrono::high_resolution_clock::now() - start;
+    }
+
+    time_ = elapsed.count();
+    if (time_ > budget())
+        overruns_++;
+}
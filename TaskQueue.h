@@ -0,0 +1,59 @@
+#ifndef TASKQUEUE_H
+#define TASKQUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <functional>
+#include <sys/types.h>
+
+/**
+ * @brief The TaskQueue class executes deferred tasks in the main thread
+ * (i.e. the thread of the OpenGL context) within a time budget per frame.
+ *
+ * Tasks (e.g. sources to insert, objects to delete) can be pushed from any
+ * thread, and are executed in order by run(), called once per frame by the
+ * Mixer: tasks are executed until TASK_QUEUE_BUDGET (ms) is spent, and at
+ * least one per frame. Tasks pushed while running are executed in the next
+ * frames. A frame where the tasks took longer than the budget is counted
+ * as an overrun.
+ */
+class TaskQueue
+{
+    // Private Constructor
+    TaskQueue();
+    TaskQueue(TaskQueue const& copy);            // Not Implemented
+    TaskQueue& operator=(TaskQueue const& copy); // Not Implemented
+
+public:
+
+    static TaskQueue& manager()
+    {
+        // The only instance
+        static TaskQueue _instance;
+        return _instance;
+    }
+
+    // add a task to execute in the main thread
+    void push(std::function<void()> task);
+
+    // execute tasks within the time budget (in main thread only)
+    void run();
+
+    // number of tasks pending
+    size_t depth();
+    // number of frames where tasks exceeded the budget
+    inline uint overruns() const { return overruns_; }
+    // time (ms) spent executing tasks in the last run
+    inline float time() const { return time_; }
+    // time budget (ms) per frame
+    static float budget();
+
+private:
+
+    std::mutex access_;
+    std::deque< std::function<void()> > tasks_;
+    uint overruns_;
+    float time_;
+};
+
+#endif // TASKQUEUE_H
@@ -1,29 +1,27 @@
 
 #include <algorithm>
+#include <iterator>
 #include <cmath>
 
 #include "defines.h"
 #include "Log.h"
 #include "Timeline.h"
 
-struct includesTime: public std::unary_function<TimeInterval, bool>
-{
-    inline bool operator()(const TimeInterval s) const
-    {
-       return s.includes(_t);
-    }
-
-    includesTime(GstClockTime t) : _t(t) { }
+// tolerance of the approximation of the fading curve by keyframes
+#define FADING_PRECISION 0.0001f
 
-private:
-    GstClockTime _t;
-};
-
-Timeline::Timeline()
+Timeline::Timeline() : gaps_array_need_update_(true), fading_array_edited_(false), fading_cursor_(0)
 {
+    gap_cursor_.valid = false;
     reset();
 }
 
+Timeline::Timeline(const Timeline& b) : Timeline()
+{
+    *this = b;
+    first_ = b.first_;
+}
+
 Timeline::~Timeline()
 {
 }
@@ -34,9 +32,17 @@ Timeline& Timeline::operator = (const Timeline& b)
         this->timing_ = b.timing_;
         this->step_ = b.step_;
         this->gaps_ = b.gaps_;
-        this->gaps_array_need_update_ = b.gaps_array_need_update_;
-        memcpy( this->gapsArray_, b.gapsArray_, MAX_TIMELINE_ARRAY * sizeof(float));
-        memcpy( this->fadingArray_, b.fadingArray_, MAX_TIMELINE_ARRAY * sizeof(float));
+        this->gap_cursor_.valid = false;
+        // arrays are not copied but filled again when requested
+        this->gaps_array_need_update_ = true;
+        if (b.fading_array_edited_)
+            this->fading_ = keyframesFromArray(b.fadingArray_.data(), b.fadingArray_.size());
+        else
+            this->fading_ = b.fading_;
+        this->fading_cursor_ = 0;
+        this->fading_array_edited_ = false;
+        if (!this->fadingArray_.empty())
+            fillArrayFromKeyframes(this->fadingArray_.data(), this->fadingArray_.size());
     }
     return *this;
 }
@@ -103,23 +109,64 @@ GstClockTime Timeline::previous(GstClockTime time) const
 
 float *Timeline::gapsArray()
 {
+    if (gapsArray_.empty()) {
+        gapsArray_.resize(MAX_TIMELINE_ARRAY, 0.f);
+        gaps_array_need_update_ = true;
+    }
     if (gaps_array_need_update_) {
-        fillArrayFromGaps(gapsArray_, MAX_TIMELINE_ARRAY);
+        fillArrayFromGaps(gapsArray_.data(), MAX_TIMELINE_ARRAY);
     }
-    return gapsArray_;
+    return gapsArray_.data();
 }
 
 void Timeline::update()
 {
-    updateGapsFromArray(gapsArray_, MAX_TIMELINE_ARRAY);
+    if (!gapsArray_.empty())
+        updateGapsFromArray(gapsArray_.data(), MAX_TIMELINE_ARRAY);
     gaps_array_need_update_ = false;
 }
 
 bool Timeline::gapAt(const GstClockTime t, TimeInterval &gap) const
 {
-    TimeIntervalSet::const_iterator g = std::find_if(gaps_.begin(), gaps_.end(), includesTime(t));
+    if ( t == GST_CLOCK_TIME_NONE )
+        return false;
+
+    // search again only if t is out of the interval found previously
+    // (a gap [begin end], or the interval ]begin end[ between gaps)
+    if ( !gap_cursor_.valid
+         || ( gap_cursor_.gap && (t < gap_cursor_.begin || t > gap_cursor_.end) )
+         || ( !gap_cursor_.gap && ((t <= gap_cursor_.begin && gap_cursor_.begin > 0) || t >= gap_cursor_.end) ) ) {
+
+        // first gap ending after t
+        TimeIntervalSet::const_iterator g = gaps_.lower_bound(t);
+
+        if ( g != gaps_.end() && !(t < (*g).begin) ) {
+            gap_cursor_.begin = (*g).begin;
+            gap_cursor_.end = (*g).end;
+            gap_cursor_.gap = true;
+        }
+        else {
+            gap_cursor_.begin = ( g == gaps_.begin() ) ? 0 : (*std::prev(g)).end;
+            gap_cursor_.end = ( g == gaps_.end() ) ? GST_CLOCK_TIME_NONE : (*g).begin;
+            gap_cursor_.gap = false;
+        }
+        gap_cursor_.valid = true;
+    }
+
+    if ( gap_cursor_.gap ) {
+        gap = TimeInterval(gap_cursor_.begin, gap_cursor_.end);
+        return true;
+    }
+
+    return false;
+}
+
+bool Timeline::nextGap(const GstClockTime t, TimeInterval &gap) const
+{
+    // first gap beginning after t
+    TimeIntervalSet::const_iterator g = gaps_.upper_bound(t);
 
-    if ( g != gaps_.end() ) {
+    if ( t != GST_CLOCK_TIME_NONE && g != gaps_.end() ) {
         gap = (*g);
         return true;
     }
@@ -127,6 +174,19 @@ bool Timeline::gapAt(const GstClockTime t, TimeInterval &gap) const
     return false;
 }
 
+bool Timeline::previousGap(const GstClockTime t, TimeInterval &gap) const
+{
+    // last gap ending before t
+    TimeIntervalSet::const_iterator g = gaps_.lower_bound(t);
+
+    if ( t != GST_CLOCK_TIME_NONE && g != gaps_.begin() ) {
+        gap = *std::prev(g);
+        return true;
+    }
+
+    return false;
+}
+
 bool Timeline::addGap(GstClockTime begin, GstClockTime end)
 {
     return addGap( TimeInterval(begin, end) );
@@ -136,6 +196,7 @@ bool Timeline::addGap(TimeInterval s)
 {
     if ( s.is_valid() ) {
         gaps_array_need_update_ = true;
+        gap_cursor_.valid = false;
         return gaps_.insert(s).second;
     }
 
@@ -145,16 +206,18 @@ bool Timeline::addGap(TimeInterval s)
 void Timeline::setGaps(TimeIntervalSet g)
 {
     gaps_array_need_update_ = true;
+    gap_cursor_.valid = false;
     gaps_ = g;
 }
 
 bool Timeline::removeGaptAt(GstClockTime t)
 {
-    TimeIntervalSet::const_iterator s = std::find_if(gaps_.begin(), gaps_.end(), includesTime(t));
+    TimeIntervalSet::const_iterator s = gaps_.find(t);
 
     if ( s != gaps_.end() ) {
         gaps_.erase(s);
         gaps_array_need_update_ = true;
+        gap_cursor_.valid = false;
         return true;
     }
 
@@ -193,8 +256,9 @@ TimeIntervalSet Timeline::sections() const
 void Timeline::clearGaps()
 {
     gaps_.clear();
+    gap_cursor_.valid = false;
 
-    for(int i=0;i<MAX_TIMELINE_ARRAY;++i)
+    for(size_t i=0;i<gapsArray_.size();++i)
         gapsArray_[i] = 0.f;
 
     gaps_array_need_update_ = true;
@@ -202,28 +266,57 @@ void Timeline::clearGaps()
 
 float Timeline::fadingAt(const GstClockTime t)
 {
+    updateFadingFromArray();
+
     double true_index = (static_cast<double>(MAX_TIMELINE_ARRAY) * static_cast<double>(t)) / static_cast<double>(timing_.end);
-    double previous_index = floor(true_index);
-    float percent = static_cast<float>(true_index - previous_index);
-    size_t keyframe_index = CLAMP( static_cast<size_t>(previous_index), 0, MAX_TIMELINE_ARRAY-1);
-    size_t keyframe_next_index = CLAMP( keyframe_index+1, 0, MAX_TIMELINE_ARRAY-1);
-    float v = fadingArray_[keyframe_index];
-    v += percent * (fadingArray_[keyframe_next_index] - fadingArray_[keyframe_index]);
+    float x = CLAMP( static_cast<float>(true_index), 0.f, static_cast<float>(MAX_TIMELINE_ARRAY-1));
+
+    // search keyframes around x, if not the same as previously
+    size_t k = fading_cursor_;
+    if ( k >= fading_.size() || fading_[k].index > x || (k+1 < fading_.size() && fading_[k+1].index < x) ) {
+        auto next = std::upper_bound(fading_.begin(), fading_.end(), x,
+                                     [](float i, const Keyframe &key) { return i < key.index; });
+        k = (next == fading_.begin()) ? 0 : (next - fading_.begin()) - 1;
+        fading_cursor_ = k;
+    }
 
-    return v;
+    if ( k + 1 >= fading_.size() )
+        return k < fading_.size() ? fading_[k].value : 1.f;
+
+    float percent = (x - fading_[k].index) / (fading_[k+1].index - fading_[k].index);
+    return fading_[k].value + percent * (fading_[k+1].value - fading_[k].value);
+}
+
+float *Timeline::fadingArray()
+{
+    if (fadingArray_.empty()) {
+        fadingArray_.resize(MAX_TIMELINE_ARRAY);
+        fillArrayFromKeyframes(fadingArray_.data(), MAX_TIMELINE_ARRAY);
+    }
+
+    // the array can be modified: keyframes are updated when needed
+    fading_array_edited_ = true;
+    return fadingArray_.data();
 }
 
 void Timeline::clearFading()
 {
+    float array[MAX_TIMELINE_ARRAY];
     for(int i=0;i<MAX_TIMELINE_ARRAY;++i)
-        fadingArray_[i] = 1.f;
+        array[i] = 1.f;
+
+    setFading(array);
 }
 
 void Timeline::smoothFading(uint N)
 {
     const float kernel[7] = { 2.f, 22.f, 97.f, 159.f, 97.f, 22.f, 2.f};
+    float array[MAX_TIMELINE_ARRAY];
     float tmparray[MAX_TIMELINE_ARRAY];
 
+    updateFadingFromArray();
+    fillArrayFromKeyframes(array, MAX_TIMELINE_ARRAY);
+
     for (uint n = 0; n < N; ++n) {
 
         for (long i = 0; i < MAX_TIMELINE_ARRAY; ++i) {
@@ -232,15 +325,17 @@ void Timeline::smoothFading(uint N)
             for( long j = 0; j < 7; ++j) {
                 long k = i - 3 + j;
                 if (k > -1 && k < MAX_TIMELINE_ARRAY-1) {
-                    tmparray[i] += fadingArray_[k] * kernel[j];
+                    tmparray[i] += array[k] * kernel[j];
                     divider += kernel[j];
                 }
             }
             tmparray[i] *= 1.f / divider;
         }
 
-        memcpy( fadingArray_, tmparray, MAX_TIMELINE_ARRAY * sizeof(float));
+        memcpy( array, tmparray, MAX_TIMELINE_ARRAY * sizeof(float));
     }
+
+    setFading(array);
 }
 
 
@@ -252,8 +347,9 @@ void Timeline::autoFading(uint milisecond)
     uint N = milisecond / stepduration;
 
     // reset all to zero
+    float array[MAX_TIMELINE_ARRAY];
     for(int i=0;i<MAX_TIMELINE_ARRAY;++i)
-        fadingArray_[i] = 0.f;
+        array[i] = 0.f;
 
     // get sections (inverse of gaps)
     TimeIntervalSet sec = sections();
@@ -273,21 +369,91 @@ void Timeline::autoFading(uint milisecond)
         // linear fade in starting at s
         size_t i = s;
         for (; i < s+n; ++i)
-            fadingArray_[i] = static_cast<float>(i-s) / static_cast<float>(n);
+            array[i] = static_cast<float>(i-s) / static_cast<float>(n);
         // plateau
         for (; i < e-n; ++i)
-            fadingArray_[i] = 1.f;
+            array[i] = 1.f;
         // linear fade out ending at e
         for (; i < e; ++i)
-            fadingArray_[i] = static_cast<float>(e-i) / static_cast<float>(n);
+            array[i] = static_cast<float>(e-i) / static_cast<float>(n);
+    }
+
+    setFading(array);
+}
+
+std::vector<Timeline::Keyframe> Timeline::keyframesFromArray(const float *array, size_t array_size)
+{
+    std::vector<Keyframe> keys;
+
+    if (array != nullptr && array_size > 0) {
+
+        // first value
+        keys.push_back( {0.f, array[0]} );
+
+        // keep only the values where the curve is not the prolongation
+        // of the line from the previous keyframe
+        for (size_t i = 1; i < array_size - 1; ++i) {
+            const Keyframe &prev = keys.back();
+            float slope = (array[i] - prev.value) / (static_cast<float>(i) - prev.index);
+            float prolongation = array[i] + slope;
+            if ( std::fabs(array[i+1] - prolongation) > FADING_PRECISION )
+                keys.push_back( {static_cast<float>(i), array[i]} );
+        }
+
+        // last value
+        if (array_size > 1)
+            keys.push_back( {static_cast<float>(array_size - 1), array[array_size - 1]} );
+    }
+
+    return keys;
+}
+
+void Timeline::fillArrayFromKeyframes(float *array, size_t array_size) const
+{
+    if (array == nullptr || array_size < 1)
+        return;
+
+    // linear interpolation between keyframes
+    size_t k = 0;
+    for (size_t i = 0; i < array_size; ++i) {
+        float x = static_cast<float>(i);
+        while ( k + 1 < fading_.size() && fading_[k+1].index < x )
+            ++k;
+        if ( k + 1 >= fading_.size() )
+            array[i] = fading_.empty() ? 1.f : fading_[k].value;
+        else {
+            float percent = (x - fading_[k].index) / (fading_[k+1].index - fading_[k].index);
+            array[i] = fading_[k].value + CLAMP(percent, 0.f, 1.f) * (fading_[k+1].value - fading_[k].value);
+        }
+    }
+}
+
+void Timeline::updateFadingFromArray()
+{
+    // values in array might have been modified
+    if (fading_array_edited_) {
+        fading_ = keyframesFromArray(fadingArray_.data(), fadingArray_.size());
+        fading_cursor_ = 0;
+        fading_array_edited_ = false;
     }
+}
+
+void Timeline::setFading(const float *array)
+{
+    fading_ = keyframesFromArray(array, MAX_TIMELINE_ARRAY);
+    fading_cursor_ = 0;
+    fading_array_edited_ = false;
 
+    // keep array (if any) in sync
+    if (!fadingArray_.empty())
+        memcpy( fadingArray_.data(), array, MAX_TIMELINE_ARRAY * sizeof(float));
 }
 
 void Timeline::updateGapsFromArray(float *array, size_t array_size)
 {
     // reset gaps
     gaps_.clear();
+    gap_cursor_.valid = false;
 
     // fill the gaps from array
     if (array != nullptr && array_size > 0 && timing_.is_valid()) {
@@ -325,8 +491,8 @@ void Timeline::fillArrayFromGaps(float *array, size_t array_size)
     // fill the array from gaps
     if (array != nullptr && array_size > 0 && timing_.is_valid()) {
 
-        for(int i=0;i<array_size;++i)
-            gapsArray_[i] = 0.f;
+        for(size_t i=0;i<array_size;++i)
+            array[i] = 0.f;
 
         // for each gap
         for (auto it = gaps_.begin(); it != gaps_.end(); ++it)
@@ -336,7 +502,7 @@ void Timeline::fillArrayFromGaps(float *array, size_t array_size)
 
             // fill with 1 where there is a gap
             for (size_t i = s; i < e; ++i) {
-                gapsArray_[i] = 1.f;
+                array[i] = 1.f;
             }
         }
 
@@ -5,6 +5,7 @@
 #include <sstream>
 #include <set>
 #include <list>
+#include <vector>
 
 #include <gst/pbutils/pbutils.h>
 
@@ -67,10 +68,21 @@ struct TimeInterval
 
 struct order_comparator
 {
+    // allows searching the interval including a time in a TimeIntervalSet
+    typedef void is_transparent;
+
     inline bool operator () (const TimeInterval a, const TimeInterval b) const
     {
         return (a < b);
     }
+    inline bool operator () (const TimeInterval a, const GstClockTime t) const
+    {
+        return (a.is_valid() && a.end < t);
+    }
+    inline bool operator () (const GstClockTime t, const TimeInterval b) const
+    {
+        return (b.is_valid() && t < b.begin);
+    }
 };
 
 typedef std::set<TimeInterval, order_comparator> TimeIntervalSet;
@@ -80,6 +92,7 @@ class Timeline
 {
 public:
     Timeline();
+    Timeline(const Timeline& b);
     ~Timeline();
     Timeline& operator = (const Timeline& b);
 
@@ -116,9 +129,14 @@ public:
     bool addGap(GstClockTime begin, GstClockTime end);
     bool removeGaptAt(GstClockTime t);
     bool gapAt(const GstClockTime t, TimeInterval &gap) const;
+    // first gap after t, last gap before t
+    bool nextGap(const GstClockTime t, TimeInterval &gap) const;
+    bool previousGap(const GstClockTime t, TimeInterval &gap) const;
 
+    // Fading curve, with array of MAX_TIMELINE_ARRAY values
+    // (created on request, e.g. for edition)
     float fadingAt(const GstClockTime t);
-    inline float *fadingArray() { return fadingArray_; }
+    float *fadingArray();
     void clearFading();
     void smoothFading(uint N = 1);
     void autoFading(uint milisecond = 100);
@@ -134,13 +152,37 @@ private:
 
     // main data structure containing list of gaps in the timeline
     TimeIntervalSet gaps_;    
-    float gapsArray_[MAX_TIMELINE_ARRAY];
+    std::vector<float> gapsArray_;
     bool gaps_array_need_update_;
     // synchronize data structures
     void updateGapsFromArray(float *array, size_t array_size);
     void fillArrayFromGaps(float *array, size_t array_size);
 
-    float fadingArray_[MAX_TIMELINE_ARRAY];
+    // result of the last search for a gap: the gap found, or the interval
+    // between the gaps around the time if there was none
+    struct GapCursor {
+        GstClockTime begin;
+        GstClockTime end;
+        bool gap;
+        bool valid;
+    };
+    mutable GapCursor gap_cursor_;
+
+    // fading curve defined by keyframes (index in array, value) linearly
+    // interpolated, and its array (empty until requested by fadingArray)
+    struct Keyframe {
+        float index;
+        float value;
+    };
+    std::vector<Keyframe> fading_;
+    std::vector<float> fadingArray_;
+    bool fading_array_edited_;
+    size_t fading_cursor_;
+    // synchronize fading data structures
+    static std::vector<Keyframe> keyframesFromArray(const float *array, size_t array_size);
+    void fillArrayFromKeyframes(float *array, size_t array_size) const;
+    void updateFadingFromArray();
+    void setFading(const float *array);
 
 };
 
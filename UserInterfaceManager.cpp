@@ -49,18 +49,24 @@ using namespace std;
 #include "ImGuiVisitor.h"
 #include "GlmToolkit.h"
 #include "GstToolkit.h"
+#include "EffectChain.h"
 #include "Mixer.h"
 #include "Recorder.h"
 #include "Streamer.h"
 #include "Loopback.h"
 #include "Selection.h"
 #include "FrameBuffer.h"
+#include "Primitives.h"
+#include "Mesh.h"
+#include "TaskQueue.h"
 #include "MediaPlayer.h"
 #include "MediaSource.h"
 #include "PatternSource.h"
 #include "DeviceSource.h"
 #include "NetworkSource.h"
+#include "NetworkToolkit.h"
 #include "StreamSource.h"
+#include "Stream.h"
 #include "PickingVisitor.h"
 #include "ImageShader.h"
 #include "ImageProcessingShader.h"
@@ -73,6 +79,7 @@ void ShowAboutGStreamer(bool* p_open);
 void ShowAboutOpengl(bool* p_open);
 void ShowConfig(bool* p_open);
 void ShowSandbox(bool* p_open);
+void ShowTextures(bool* p_open);
 
 // static objects for multithreaded file dialog
 const std::chrono::milliseconds timeout = std::chrono::milliseconds(4);
@@ -168,6 +175,9 @@ UserInterface::UserInterface()
     // keep hold on frame grabbers
     video_recorder_ = 0;
     webcam_emulator_ = 0;
+
+    effect_source_ = 0;
+    effect_pass_ = 0;
 }
 
 bool UserInterface::Init()
@@ -856,6 +866,7 @@ ToolBox::ToolBox()
     show_demo_window = false;
     show_icons_window = false;
     show_sandbox = false;
+    show_textures = false;
 }
 
 void UserInterface::StartScreenshot()
@@ -898,6 +909,101 @@ void UserInterface::handleScreenshot()
 }
 
 
+// time (ms per frame) to draw the scene, recursively or with its render list
+static float timeSceneDrawing(Scene &scene, FrameBuffer *fb, bool renderlist, int frames)
+{
+    glFinish();
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int f = 0; f < frames; ++f) {
+        fb->begin();
+        if (renderlist)
+            scene.draw(fb->projection());
+        else
+            scene.root()->draw(glm::identity<glm::mat4>(), fb->projection());
+        fb->end();
+    }
+    glFinish();
+    std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return elapsed.count() / (float) frames;
+}
+
+// compare recursive drawing with render list on synthetic scenes of
+// groups containing sub-groups of surfaces
+static void benchmarkSceneDrawing()
+{
+    static const int scenes[3][3] = { {50, 4, 5}, {100, 10, 5}, {200, 10, 10} };
+    static const int frames = 20;
+
+    FrameBuffer *fb = new FrameBuffer(64, 64);
+
+    for (int i = 0; i < 3; ++i) {
+        Scene scene;
+        for (int g = 0; g < scenes[i][0]; ++g) {
+            Group *group = new Group;
+            group->translation_ = glm::vec3(glm::sin( (float) g ), glm::cos( (float) g ), 0.001f * g);
+            group->scale_ = glm::vec3(0.1f, 0.1f, 1.f);
+            for (int c = 0; c < scenes[i][1]; ++c) {
+                Group *child = new Group;
+                child->rotation_.z = 0.1f * c;
+                child->scale_ = glm::vec3(0.5f, 0.5f, 1.f);
+                for (int p = 0; p < scenes[i][2]; ++p) {
+                    Surface *surface = new Surface;
+                    surface->translation_ = glm::vec3(0.1f * p, 0.f, 0.001f * p);
+                    child->attach(surface);
+                }
+                group->attach(child);
+            }
+            scene.ws()->attach(group);
+        }
+        scene.update(0.f);
+
+        // first draw initializes nodes and builds render list
+        timeSceneDrawing(scene, fb, false, 1);
+        timeSceneDrawing(scene, fb, true, 1);
+
+        float recursive = timeSceneDrawing(scene, fb, false, frames);
+        float renderlist = timeSceneDrawing(scene, fb, true, frames);
+
+        // traversal only: hide surfaces (but not their groups)
+        for (auto g = scene.ws()->begin(); g != scene.ws()->end(); g++) {
+            Group *group = static_cast<Group *>(*g);
+            for (auto c = group->begin(); c != group->end(); c++) {
+                Group *child = static_cast<Group *>(*c);
+                for (auto p = child->begin(); p != child->end(); p++)
+                    (*p)->visible_ = false;
+            }
+        }
+        float recursive_traversal = timeSceneDrawing(scene, fb, false, frames);
+        float renderlist_traversal = timeSceneDrawing(scene, fb, true, frames);
+
+        Log::Info("Scene of %d surfaces: draw %.2f ms recursive, %.2f ms render list; "
+                  "traversal %.3f ms recursive, %.3f ms render list.",
+                  scenes[i][0] * scenes[i][1] * scenes[i][2], recursive, renderlist,
+                  recursive_traversal, renderlist_traversal);
+    }
+
+    delete fb;
+}
+
+// time (ms) to load all meshes of resources, parsing PLY files or from packed meshes
+static void benchmarkMeshLoading()
+{
+    std::list<std::string> meshes = Resource::listFiles("mesh", ".ply");
+    float time[2] = {0.f, 0.f};
+
+    for (int p = 0; p < 2; ++p) {
+        Mesh::packed = p > 0;
+        float start = Mesh::loadingTime();
+        for (auto m = meshes.begin(); m != meshes.end(); m++)
+            delete new Mesh(*m);
+        time[p] = Mesh::loadingTime() - start;
+    }
+    Mesh::packed = true;
+
+    Log::Info("Loading %d meshes: %.2f ms parsing PLY files, %.2f ms from packed meshes.",
+              (int) meshes.size(), time[0], time[1]);
+}
+
 void ToolBox::Render()
 {
     // first run
@@ -917,6 +1023,37 @@ void ToolBox::Render()
         {
             if ( ImGui::MenuItem( ICON_FA_CAMERA_RETRO "  Screenshot", "F12") )
                 UserInterface::manager().StartScreenshot();
+            if ( ImGui::MenuItem( ICON_FA_STOPWATCH "  Benchmark scene drawing") )
+                benchmarkSceneDrawing();
+            if ( ImGui::MenuItem( ICON_FA_STOPWATCH "  Benchmark mesh loading") )
+                benchmarkMeshLoading();
+            ImGui::MenuItem( ICON_FA_IMAGES "  Textures", nullptr, &show_textures);
+
+            ImGui::EndMenu();
+        }
+        if (ImGui::BeginMenu("Stream"))
+        {
+            ImGui::MenuItem("Loopback test", nullptr, false, false);
+            for (int p = NetworkToolkit::UDP_JPEG; p < NetworkToolkit::DEFAULT; ++p) {
+                // only datagram protocols go through the lossy relay
+                if (p == NetworkToolkit::TCP_JPEG || p == NetworkToolkit::TCP_H264)
+                    continue;
+                bool testing = Streaming::manager().testProtocol() == p;
+                if ( ImGui::MenuItem( NetworkToolkit::protocol_name[p], nullptr, &testing,
+                                      Streaming::available( (NetworkToolkit::Protocol) p) ) ) {
+                    if (testing)
+                        Streaming::manager().startTest( (NetworkToolkit::Protocol) p, Settings::application.stream.test_loss);
+                    else
+                        Streaming::manager().stopTest();
+                }
+            }
+            int percent = int( Settings::application.stream.test_loss * 100.f );
+            ImGui::SetNextItemWidth(IMGUI_RIGHT_ALIGN);
+            if ( ImGui::SliderInt("Packet loss", &percent, 0, 50, "%d %%") ) {
+                Settings::application.stream.test_loss = float(percent) / 100.f;
+                if (Streaming::manager().testRelay())
+                    Streaming::manager().testRelay()->setLoss(Settings::application.stream.test_loss);
+            }
 
             ImGui::EndMenu();
         }
@@ -931,6 +1068,40 @@ void ToolBox::Render()
         ImGui::EndMenuBar();
     }
 
+    // loopback streaming test
+    Stream *teststream = Streaming::manager().testStream();
+    if (teststream) {
+        if ( Streaming::manager().testing() ) {
+            teststream->update();
+
+            // throughput measured by the relay every second
+            static double last_time = 0.0;
+            static uint64_t last_bytes = 0;
+            static float kbps = 0.f;
+            NetworkToolkit::LossyRelay *relay = Streaming::manager().testRelay();
+            double now = ImGui::GetTime();
+            if (now - last_time > 1.0) {
+                uint64_t b = relay->bytes();
+                kbps = b > last_bytes ? float( (b - last_bytes) * 8 ) / float(1000.0 * (now - last_time)) : 0.f;
+                last_bytes = b;
+                last_time = now;
+            }
+
+            ImGui::Text("%s with %.0f%% loss", NetworkToolkit::protocol_name[Streaming::manager().testProtocol()], relay->loss() * 100.f);
+            ImGui::Text("Received %.1f fps, %.0f kbit/s", teststream->updateFrameRate(), kbps);
+            ImGui::Text("Dropped %lu / %lu packets", (unsigned long) relay->dropped(), (unsigned long) (relay->packets() + relay->dropped()) );
+            GstClockTime latency = teststream->latency();
+            if (GST_CLOCK_TIME_IS_VALID(latency))
+                ImGui::Text("Latency %lu ms", (unsigned long) GST_TIME_AS_MSECONDS(latency) );
+
+            float w = ImGui::GetContentRegionAvail().x;
+            ImGui::Image((void*)(intptr_t)teststream->texture(), ImVec2(w, w / teststream->aspectRatio()));
+        }
+        else
+            Streaming::manager().stopTest();
+        ImGui::Separator();
+    }
+
     static char buf1[128] = "videotestsrc pattern=smpte";
     ImGui::InputText("gstreamer pipeline", buf1, 128);
     if (ImGui::Button("Create Generic Stream Source") )
@@ -939,6 +1110,13 @@ void ToolBox::Render()
     }
 
 
+    // deferred tasks of the main thread
+    ImGui::Text("Tasks %d pending, %.1f ms last frame, %d overruns of %.0f ms",
+                (int) TaskQueue::manager().depth(), TaskQueue::manager().time(),
+                TaskQueue::manager().overruns(), TaskQueue::budget());
+    // pipelines of closed media players and streams stopping in background
+    ImGui::Text("Pipelines %d stopping", (int) GstToolkit::pipeline_teardown_pending());
+
     //
     // display histogram of update time and plot framerate
     //
@@ -1004,6 +1182,8 @@ void ToolBox::Render()
         ImGuiToolkit::ShowIconsWindow(&show_icons_window);    
     if (show_sandbox)
         ShowSandbox(&show_sandbox);
+    if (show_textures)
+        ShowTextures(&show_textures);
     if (show_demo_window)
         ImGui::ShowDemoWindow(&show_demo_window);
 
@@ -1125,6 +1305,8 @@ void UserInterface::RenderPreview()
                 if ( ImGui::MenuItem( ICON_FA_SHARE_SQUARE "  Create Source") )
                     Mixer::manager().addSource( Mixer::manager().createSourceRender() );
 
+                ImGui::MenuItem( ICON_FA_COMPRESS "  Adapt sources resolution", nullptr, &Settings::application.render.lod);
+
                 if ( ImGui::MenuItem( ICON_FA_TIMES "  Close") )
                     Settings::application.widget.preview = false;
 
@@ -1232,6 +1414,19 @@ void UserInterface::RenderPreview()
                     sprintf(dummy_str, "%s", Connection::manager().info().name.c_str());
                     ImGui::InputText("My ID", dummy_str, IM_ARRAYSIZE(dummy_str), ImGuiInputTextFlags_ReadOnly);
 
+                    // protocol offered to the next connections (shared memory is not offered)
+                    int p = CLAMP(Settings::application.stream.protocol, (int) NetworkToolkit::UDP_JPEG, (int) NetworkToolkit::DEFAULT - 1);
+                    if (ImGui::BeginCombo("Protocol", NetworkToolkit::protocol_name[p]))
+                    {
+                        for (int i = NetworkToolkit::UDP_JPEG; i < NetworkToolkit::DEFAULT; ++i) {
+                            bool available = Streaming::available( (NetworkToolkit::Protocol) i);
+                            if (ImGui::Selectable( NetworkToolkit::protocol_name[i], i == p,
+                                                   available ? ImGuiSelectableFlags_None : ImGuiSelectableFlags_Disabled) )
+                                Settings::application.stream.protocol = i;
+                        }
+                        ImGui::EndCombo();
+                    }
+
                     std::vector<std::string> ls = Streaming::manager().listStreams();
                     if (ls.size()>0) {
                         ImGui::Separator();
@@ -1488,7 +1683,7 @@ void MediaController::Render()
             // display media information
             if (ImGui::IsItemHovered()) {
 
-                float tooltip_height = 3.f * ImGui::GetTextLineHeightWithSpacing();
+                float tooltip_height = (mp_->timeline()->numGaps() > 0 ? 4.f : 3.f) * ImGui::GetTextLineHeightWithSpacing();
 
                 ImDrawList* draw_list = ImGui::GetWindowDrawList();
                 draw_list->AddRectFilled(ImVec2(tooltip_pos.x - 10.f, tooltip_pos.y),
@@ -1501,6 +1696,9 @@ void MediaController::Render()
                     ImGui::Text(" %d x %d px, %.2f / %.2f fps", mp_->width(), mp_->height(), mp_->updateFrameRate() , mp_->frameRate() );
                 else
                     ImGui::Text(" %d x %d px", mp_->width(), mp_->height());
+                if ( mp_->timeline()->numGaps() > 0 )
+                    ImGui::Text(" %d gaps, %ld ms stall at last jump", (int) mp_->timeline()->numGaps(),
+                                (long) GST_TIME_AS_MSECONDS(mp_->gapStall()) );
 
             }
 
@@ -1712,6 +1910,27 @@ void UserInterface::fillShaderEditor(std::string text)
     editor.SetText(currentTextEdit);
 }
 
+void UserInterface::editEffect(uint64_t source, size_t pass)
+{
+    effect_source_ = source;
+    effect_pass_ = pass;
+
+    EffectPass *p = editedEffect();
+    if (p) {
+        fillShaderEditor(p->code());
+        Settings::application.widget.shader_editor = true;
+    }
+}
+
+EffectPass *UserInterface::editedEffect()
+{
+    // the source or its pass may have been deleted
+    Source *s = Mixer::manager().findSource(effect_source_);
+    if ( s == nullptr || effect_pass_ >= s->effects()->size() )
+        return nullptr;
+    return s->effects()->pass(effect_pass_);
+}
+
 void UserInterface::RenderShaderEditor()
 {
     static bool show_statusbar = true;
@@ -1751,6 +1970,18 @@ void UserInterface::RenderShaderEditor()
             ImGui::EndMenu();
         }
 
+        EffectPass *effect = editedEffect();
+        if (ImGui::BeginMenu("Effect", effect != nullptr))
+        {
+            if (ImGui::MenuItem( ICON_FA_CHECK " Apply")) {
+                effect->setCode( editor.GetText() );
+                Action::manager().store("Effect " + effect->name + " changed", effect_source_);
+            }
+            if (ImGui::MenuItem( ICON_FA_UNDO " Revert"))
+                fillShaderEditor( effect->code() );
+            ImGui::EndMenu();
+        }
+
         if (ImGui::BeginMenu("View"))
         {
             bool ws = editor.IsShowingWhitespaces();
@@ -1768,6 +1999,14 @@ void UserInterface::RenderShaderEditor()
             editor.IsOverwrite() ? "Ovr" : "Ins",
             editor.CanUndo() ? "*" : " ",
             editor.GetLanguageDefinition().mName.c_str());
+        EffectPass *effect = editedEffect();
+        if (effect) {
+            ImGui::SameLine();
+            if (effect->valid())
+                ImGui::TextDisabled("| Effect %s %.2f ms", effect->name.c_str(), effect->gpuTime());
+            else
+                ImGui::TextColored(ImVec4(IMGUI_COLOR_RECORD, 1.0), "| Effect %s : error (see logs)", effect->name.c_str());
+        }
     }
 
     ImGuiToolkit::PushFont(ImGuiToolkit::FONT_MONO);
@@ -2747,6 +2986,47 @@ int hover(const char *label)
 #define SEGMENT_ARRAY_MAX 1000
 
 
+void ShowTextures(bool* p_open)
+{
+    ImGui::SetNextWindowPos(ImVec2(100, 100), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(400, 300), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin( ICON_FA_IMAGES "  Textures", p_open))
+    {
+        ImGui::End();
+        return;
+    }
+
+    // textures of resources, in use or kept in cache
+    std::list<Resource::TextureInfo> textures = Resource::listTextures();
+    long used = 0, cached = 0;
+    ImGui::Columns(3, "textures");
+    ImGui::Text("Resource"); ImGui::NextColumn();
+    ImGui::Text("Memory"); ImGui::NextColumn();
+    ImGui::Text("Users"); ImGui::NextColumn();
+    ImGui::Separator();
+    for (auto it = textures.begin(); it != textures.end(); ++it) {
+        ImGui::Text("%s", it->path.c_str()); ImGui::NextColumn();
+        ImGui::Text("%s", SystemToolkit::byte_to_string(it->memory).c_str()); ImGui::NextColumn();
+        if (it->references > 0) {
+            ImGui::Text("%d", it->references);
+            used += it->memory;
+        }
+        else {
+            ImGui::TextDisabled("cached");
+            cached += it->memory;
+        }
+        ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+    ImGui::Separator();
+    ImGui::Text("%s in use, %s cached", SystemToolkit::byte_to_string(used).c_str(),
+                SystemToolkit::byte_to_string(cached).c_str());
+    ImGui::SetNextItemWidth(200);
+    ImGui::SliderInt("Cache", &Settings::application.render.texture_cache, 0, 2048, "%d MB");
+
+    ImGui::End();
+}
+
 void ShowSandbox(bool* p_open)
 {
     ImGui::SetNextWindowPos(ImVec2(100, 100), ImGuiCond_FirstUseEver);
@@ -2920,7 +3200,12 @@ void ShowConfig(bool* p_open)
         bool vsync = (Settings::application.render.vsync < 2);
         ImGui::Checkbox("Sync refresh with monitor (v-sync 60Hz)", &vsync);
         Settings::application.render.vsync = vsync ? 1 : 2;
+        ImGui::Checkbox("Keep compiled shaders (fast start)", &Settings::application.render.shader_cache);
+        ImGui::Checkbox("Compress large images (less GPU memory)", &Settings::application.render.texture_compression);
         ImGui::Text( ICON_FA_EXCLAMATION "  Restart the application for change to take effect.");
+        ImGui::Text("\nGPU memory options (applied immediately).");
+        ImGui::SetNextItemWidth(200);
+        ImGui::SliderInt("GPU memory budget", &Settings::application.render.gpu_budget, 256, 8192, "%d MB");
     }
 
     ImGui::End();
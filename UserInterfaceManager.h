@@ -74,6 +74,7 @@ class ToolBox
     bool show_demo_window;
     bool show_icons_window;
     bool show_sandbox;
+    bool show_textures;
 
 public:
     ToolBox();
@@ -119,6 +120,11 @@ class UserInterface
     uint64_t video_recorder_;
     uint64_t webcam_emulator_;
 
+    // effect pass edited in the shader editor
+    uint64_t effect_source_;
+    size_t effect_pass_;
+    class EffectPass *editedEffect();
+
     // Private Constructor
     UserInterface();
     UserInterface(UserInterface const& copy);            // Not Implemented
@@ -155,6 +161,8 @@ public:
     // TODO implement the shader editor
     std::string currentTextEdit;
     void fillShaderEditor(std::string text);
+    // edit the code of an effect pass of a source in the shader editor
+    void editEffect(uint64_t source, size_t pass);
 
 protected:
 
@@ -27,6 +27,7 @@
 #include "BoundingBoxVisitor.h"
 #include "DrawVisitor.h"
 #include "Decorations.h"
+#include "InstanceBatch.h"
 #include "Mixer.h"
 #include "UserInterfaceManager.h"
 #include "UpdateCallback.h"
@@ -36,7 +37,7 @@
 
 bool View::need_deep_update_ = true;
 
-View::View(Mode m) : mode_(m)
+View::View(Mode m) : mode_(m), index_revision_(0), index_modelview_(glm::mat4(0.f))
 {
 }
 
@@ -54,8 +55,10 @@ void View::saveSettings()
 
 void View::draw()
 {
-    // draw scene of this view
-    scene.root()->draw(glm::identity<glm::mat4>(), Rendering::manager().Projection());
+    // draw scene of this view, with decorations drawn in batches of instances
+    InstanceBatch::manager().begin(Rendering::manager().Projection());
+    scene.draw(Rendering::manager().Projection());
+    InstanceBatch::manager().end();
 }
 
 void View::update(float dt)
@@ -101,6 +104,7 @@ std::pair<Node *, glm::vec2> View::pick(glm::vec2 P)
 
     // picking visitor traverses the scene
     PickingVisitor pv(scene_point_);
+    pickCandidates(pv, scene_point_, scene_point_);
     scene.accept(pv);
 
     // picking visitor found nodes?
@@ -194,6 +198,50 @@ void View::selectAll()
     }
 }
 
+void View::pickCandidates(PickingVisitor &pv, glm::vec3 A, glm::vec3 B)
+{
+    // rebuild index of bounding boxes of the workspace nodes if the workspace changed
+    // (since last update) or if it is seen with another transform
+    glm::mat4 mv = scene.root()->transform_ * scene.ws()->transform_;
+    if ( index_revision_ != scene.ws()->changed() || index_modelview_ != mv ) {
+        index_revision_ = scene.ws()->changed();
+        index_modelview_ = mv;
+        indexed_nodes_.clear();
+        unindexed_nodes_.clear();
+
+        std::vector<GlmToolkit::AxisAlignedBoundingBox> boxes;
+        for (NodeSet::iterator node = scene.ws()->begin(); node != scene.ws()->end(); node++) {
+            BoundingBoxVisitor vbox;
+            vbox.setModelview(mv);
+            (*node)->accept(vbox);
+            GlmToolkit::AxisAlignedBoundingBox box = vbox.bbox();
+            // nothing visible to compute a box: always a candidate
+            if ( box.isNull() )
+                unindexed_nodes_.push_back(*node);
+            else {
+                // margin for the decorations around surfaces (handles, symbols)
+                glm::vec3 margin = box.scale() * 0.3f + glm::vec3(PICKING_MARGIN);
+                box.extend(box.min() - margin);
+                box.extend(box.max() + margin);
+                boxes.push_back(box);
+                indexed_nodes_.push_back(*node);
+            }
+        }
+        index_.build(boxes);
+    }
+
+    // candidates are the nodes around the points
+    GlmToolkit::AxisAlignedBoundingBox area;
+    area.extend(A);
+    area.extend(B);
+    std::vector<Node *> candidates = unindexed_nodes_;
+    std::vector<uint> found = index_.intersecting(area);
+    for (auto i = found.begin(); i != found.end(); i++)
+        candidates.push_back( indexed_nodes_[*i] );
+
+    pv.setCandidates(scene.ws(), candidates);
+}
+
 void View::select(glm::vec2 A, glm::vec2 B)
 {
     // unproject mouse coordinate into scene coordinates
@@ -202,6 +250,7 @@ void View::select(glm::vec2 A, glm::vec2 B)
 
     // picking visitor traverses the scene
     PickingVisitor pv(scene_point_A, scene_point_B);
+    pickCandidates(pv, scene_point_A, scene_point_B);
     scene.accept(pv);
 
     // reset selection
@@ -672,7 +721,7 @@ void RenderView::draw()
     // draw in frame buffer
     glm::mat4 P  = glm::scale( projection, glm::vec3(1.f / frame_buffer_->aspectRatio(), 1.f, 1.f));
     frame_buffer_->begin();
-    scene.root()->draw(glm::identity<glm::mat4>(), P);
+    scene.draw(P);
     fading_overlay_->draw(glm::identity<glm::mat4>(), projection);
     frame_buffer_->end();
 }
@@ -866,11 +915,13 @@ void GeometryView::draw()
 
     // re-draw frames of all sources on top
     // (otherwise hidden in stack of sources)
+    InstanceBatch::manager().begin(Rendering::manager().Projection());
     for (auto source_iter = Mixer::manager().session()->begin(); source_iter != Mixer::manager().session()->end(); source_iter++)
     {
         DrawVisitor dv((*source_iter)->frames_[mode_], Rendering::manager().Projection());
         scene.accept(dv);
     }
+    InstanceBatch::manager().end();
 
     // re-draw overlay of current source on top
     // (allows manipulation current source even when hidden below others)
@@ -903,6 +954,7 @@ std::pair<Node *, glm::vec2> GeometryView::pick(glm::vec2 P)
 
     // picking visitor traverses the scene
     PickingVisitor pv(scene_point_);
+    pickCandidates(pv, scene_point_, scene_point_);
     scene.accept(pv);
 
     // picking visitor found nodes?
@@ -1570,7 +1622,7 @@ void TransitionView::draw()
     gradient_->setActive( 2*Settings::application.transition.profile + (Settings::application.transition.cross_fade ? 0 : 1) );
 
     // draw scene of this view
-    scene.root()->draw(glm::identity<glm::mat4>(), Rendering::manager().Projection());
+    scene.draw(Rendering::manager().Projection());
 
     // 100ms tic marks
     int n = static_cast<int>( Settings::application.transition.duration / 0.1f );
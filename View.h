@@ -5,6 +5,7 @@
 
 #include "Scene.h"
 #include "FrameBuffer.h"
+#include "GlmToolkit.h"
 
 class Source;
 typedef std::list<Source *> SourceList;
@@ -14,6 +15,7 @@ class Surface;
 class Symbol;
 class Mesh;
 class Frame;
+class PickingVisitor;
 
 class View
 {
@@ -90,6 +92,15 @@ protected:
     std::string current_action_;
     uint64_t current_id_;
     Mode mode_;
+
+    // spatial index of the nodes of the workspace, rebuilt when the
+    // workspace changed, to pick only the nodes around the given points
+    void pickCandidates(PickingVisitor &pv, glm::vec3 A, glm::vec3 B);
+    GlmToolkit::BoundingBoxTree index_;
+    std::vector<Node *> indexed_nodes_;
+    std::vector<Node *> unindexed_nodes_;
+    uint64_t index_revision_;
+    glm::mat4 index_modelview_;
 };
 
 
@@ -0,0 +1,55 @@
+/**
+ * meshpack : convert a PLY file (ascii or binary little endian) into the
+ * packed mesh format loaded by the Mesh class of vimix.
+ *
+ * Usage: meshpack input.ply output.mesh
+ *
+ * The PLY file is parsed and packed by the same code as in vimix
+ * (see MeshParser.cpp), so that packed meshes are identical to the
+ * meshes parsed at runtime.
+ *
+ * Built and run by CMake to generate the packed meshes embedded in resources.
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+
+#include "MeshParser.h"
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: meshpack input.ply output.mesh\n");
+        return 1;
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file) {
+        fprintf(stderr, "meshpack: %s: cannot open file\n", argv[1]);
+        return 1;
+    }
+    std::string content( (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>() );
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec4> colors;
+    std::vector<glm::vec2> uv;
+    std::vector<uint> indices;
+    uint primitive = 0;
+    std::string error;
+    if ( !MeshParser::parsePLY(content, positions, colors, uv, indices, primitive, error) ) {
+        fprintf(stderr, "meshpack: %s: %s\n", argv[1], error.c_str());
+        return 1;
+    }
+
+    std::string data = MeshParser::pack(positions, colors, uv, indices, primitive);
+    std::ofstream out(argv[2], std::ios::binary | std::ios::trunc);
+    if ( !out || !out.write(data.data(), data.size()) ) {
+        fprintf(stderr, "meshpack: %s: cannot write file\n", argv[2]);
+        return 1;
+    }
+
+    return 0;
+}
@@ -9,6 +9,10 @@
 #define XML_VERSION_MAJOR 0
 #define XML_VERSION_MINOR 1
 #define MAX_RECENT_HISTORY 20
+#define MAX_SESSION_LEVEL 3
+#define SESSION_INIT_BUDGET 4.f
+#define TASK_QUEUE_BUDGET 2.f
+#define MAX_SOURCE_LOD 3
 
 #define MINI(a, b)  (((a) < (b)) ? (a) : (b))
 #define MAXI(a, b)  (((a) > (b)) ? (a) : (b))
@@ -45,6 +49,7 @@
 #define TRANSITION_DEFAULT_SCALE 5.0f
 #define TRANSITION_MIN_DURATION 0.2f
 #define TRANSITION_MAX_DURATION 10.f
+#define PICKING_MARGIN 0.25f
 
 #define IMGUI_TITLE_MAINWINDOW ICON_FA_CIRCLE_NOTCH "  vimix"
 #define IMGUI_TITLE_MEDIAPLAYER ICON_FA_FILM "  Player"
@@ -1,6 +1,7 @@
 
 #include <stdio.h>
 #include <iostream>
+#include <chrono>
 
 // standalone image loader
 #include "stb_image.h"
@@ -29,6 +30,7 @@
 #include "RenderingManager.h"
 #include "UserInterfaceManager.h"
 #include "Connection.h"
+#include "Log.h"
 
 
 #if defined(APPLE)
@@ -45,6 +47,19 @@ void drawScene()
     Mixer::manager().draw();
 }
 
+// log the time spent in each phase of initialization, from start of main() to first frame
+static std::chrono::high_resolution_clock::time_point startup_time = std::chrono::high_resolution_clock::now();
+
+void startupPhase(const char *phase)
+{
+    static std::chrono::high_resolution_clock::time_point previous = startup_time;
+    std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<float, std::milli> elapsed = now - previous;
+    std::chrono::duration<float, std::milli> total = now - startup_time;
+    Log::Info("Startup: %s in %.1f ms (%.1f ms total).", phase, elapsed.count(), total.count());
+    previous = now;
+}
+
 int main(int argc, char *argv[])
 {
     // one extra argument is given
@@ -67,24 +82,28 @@ int main(int argc, char *argv[])
 
     /// lock to inform an instance is running
     Settings::Lock();
+    startupPhase("settings");
 
     ///
     /// CONNECTION INIT
     ///
     if ( !Connection::manager().init() )
         return 1;
+    startupPhase("connection");
 
     ///
     /// RENDERING INIT
     ///
     if ( !Rendering::manager().init() )
         return 1;
+    startupPhase("rendering");
 
     ///
     /// UI INIT
     ///
     if ( !UserInterface::manager().Init() )
         return 1;
+    startupPhase("user interface");
 
     ///
     /// GStreamer
@@ -100,12 +119,23 @@ int main(int argc, char *argv[])
 //     test text editor
 //    UserInterface::manager().fillShaderEditor( Resource::getText("shaders/image.fs") );
 
+    ///
+    /// MIXER INIT (views and session)
+    ///
+    Mixer::manager();
+    startupPhase("mixer");
+
     // draw the scene
     Rendering::manager().pushFrontDrawCallback(drawScene);
 
     // show all windows
     Rendering::manager().show();
 
+    // first frame
+    Mixer::manager().update();
+    Rendering::manager().draw();
+    startupPhase("first frame");
+
     ///
     /// Main LOOP
     ///
@@ -131,6 +161,10 @@ int main(int argc, char *argv[])
     ///
     Connection::manager().terminate();
 
+    /// pipelines not yet stopped by the reaper are abandoned
+    if (GstToolkit::pipeline_teardown_pending() > 0)
+        Log::Info("%d pipeline(s) still stopping on exit.", (int) GstToolkit::pipeline_teardown_pending());
+
     /// unlock on clean exit
     Settings::Unlock();
 
@@ -0,0 +1,26 @@
+#version 330 core
+
+/*
+** Pass of an EffectChain
+** The code of the effect is appended to this file, and shall define
+** mainImage() with the ShaderToy convention. The input image is in
+** iChannel0 and the resolution of the output is in iResolution.
+*/
+
+out vec4 FragColor;
+
+in vec4 vertexColor;
+in vec2 vertexUV;
+
+uniform sampler2D iChannel0;             // input image (previous pass)
+uniform vec3      iResolution;           // output resolution (in pixels)
+uniform float     iTime;                 // time since creation of the effect (in seconds)
+uniform int       iFrame;                // frame count since creation of the effect
+
+void mainImage( out vec4 fragColor, in vec2 fragCoord );
+
+void main()
+{
+    mainImage(FragColor, gl_FragCoord.xy);
+}
+
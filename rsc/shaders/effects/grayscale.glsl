@@ -0,0 +1,7 @@
+void mainImage( out vec4 fragColor, in vec2 fragCoord )
+{
+    vec2 uv = fragCoord / iResolution.xy;
+    vec4 c = texture(iChannel0, uv);
+    float l = dot(c.rgb, vec3(0.2126, 0.7152, 0.0722));
+    fragColor = vec4(vec3(l), c.a);
+}
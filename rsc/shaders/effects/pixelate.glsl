@@ -0,0 +1,7 @@
+void mainImage( out vec4 fragColor, in vec2 fragCoord )
+{
+    // blocks of 1% of the height
+    float size = max(1.0, floor(iResolution.y / 100.0));
+    vec2 block = (floor(fragCoord / size) + 0.5) * size;
+    fragColor = texture(iChannel0, block / iResolution.xy);
+}
@@ -0,0 +1,7 @@
+void mainImage( out vec4 fragColor, in vec2 fragCoord )
+{
+    vec2 uv = fragCoord / iResolution.xy;
+    vec4 c = texture(iChannel0, uv);
+    float line = 0.75 + 0.25 * sin( (fragCoord.y + iTime * 30.0) * 3.14159 * 0.5 );
+    fragColor = vec4(c.rgb * line, c.a);
+}
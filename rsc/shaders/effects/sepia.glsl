@@ -0,0 +1,9 @@
+void mainImage( out vec4 fragColor, in vec2 fragCoord )
+{
+    vec2 uv = fragCoord / iResolution.xy;
+    vec4 c = texture(iChannel0, uv);
+    vec3 s = vec3( dot(c.rgb, vec3(0.393, 0.769, 0.189)),
+                   dot(c.rgb, vec3(0.349, 0.686, 0.168)),
+                   dot(c.rgb, vec3(0.272, 0.534, 0.131)) );
+    fragColor = vec4(min(s, vec3(1.0)), c.a);
+}
@@ -0,0 +1,8 @@
+// iChannel0 : image of the previous pass
+// iResolution : resolution of the output (in pixels)
+// iTime : time in seconds, iFrame : frame count
+void mainImage( out vec4 fragColor, in vec2 fragCoord )
+{
+    vec2 uv = fragCoord / iResolution.xy;
+    fragColor = texture(iChannel0, uv);
+}
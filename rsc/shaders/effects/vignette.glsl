@@ -0,0 +1,8 @@
+void mainImage( out vec4 fragColor, in vec2 fragCoord )
+{
+    vec2 uv = fragCoord / iResolution.xy;
+    vec4 c = texture(iChannel0, uv);
+    vec2 d = uv - vec2(0.5);
+    float v = smoothstep(0.8, 0.3, length(d));
+    fragColor = vec4(c.rgb * v, c.a);
+}
@@ -0,0 +1,50 @@
+#version 330 core
+
+/*
+** One pass of a separable filter (see ImageFilter):
+** 2 x radius + 1 texture fetches along the given direction.
+** A copy (radius 0) to a smaller frame buffer downsamples the image.
+*/
+
+out vec4 FragColor;
+
+in vec4 vertexColor;
+in vec2 vertexUV;
+
+uniform sampler2D iChannel0;             // input channel (texture id).
+
+uniform vec2 direction;                  // one pixel step in the direction of the pass
+uniform int  radius;                     // number of pixels on each side
+uniform int  operation;                  // 0 gaussian, 1 erosion (min), 2 dilation (max)
+
+void main()
+{
+    vec4 center = texture(iChannel0, vertexUV);
+    vec3 result = center.rgb;
+
+    if (operation == 0) {
+        // gaussian weights; for radius 1, the [1 2 1] / 4 kernel
+        float sigma = max(0.5 * float(radius), 0.8493218);
+        float total = 1.0;
+        for (int i = 1; i <= radius; ++i) {
+            float w = exp( - float(i * i) / (2.0 * sigma * sigma) );
+            result += w * ( texture(iChannel0, vertexUV + float(i) * direction).rgb
+                          + texture(iChannel0, vertexUV - float(i) * direction).rgb );
+            total += 2.0 * w;
+        }
+        result /= total;
+    }
+    else if (operation == 1) {
+        for (int i = 1; i <= radius; ++i)
+            result = min(result, min( texture(iChannel0, vertexUV + float(i) * direction).rgb,
+                                      texture(iChannel0, vertexUV - float(i) * direction).rgb ) );
+    }
+    else {
+        for (int i = 1; i <= radius; ++i)
+            result = max(result, max( texture(iChannel0, vertexUV + float(i) * direction).rgb,
+                                      texture(iChannel0, vertexUV - float(i) * direction).rgb ) );
+    }
+
+    // alpha is not filtered
+    FragColor = vec4(result, center.a);
+}
@@ -15,6 +15,14 @@
 #define LevelsControlOutputRange(color, minOutput, maxOutput)  mix(vec3(minOutput), vec3(maxOutput), color)
 #define LevelsControl(color, minInput, gamma, maxInput, minOutput, maxOutput)   LevelsControlOutputRange(LevelsControlInput(color, minInput, gamma, maxInput), minOutput, maxOutput)
 
+/*
+** Features compiled in this variant of the shader
+** (defined by ImageProcessingShader; all defined in the generic variant)
+*/
+#if defined(INVERT_LUMA) || defined(HUESHIFT) || defined(SATURATION) || defined(POSTERIZE) || defined(LUMAKEY) || defined(THRESHOLD)
+#define HSL
+#endif
+
 #define ONETHIRD 0.333333
 #define TWOTHIRD 0.666666
 #define EPSILON  0.000001
@@ -37,26 +45,33 @@ uniform vec4 color;
 uniform vec4 uv;
 
 // Image processing uniforms
-uniform float contrast;
-uniform float brightness;
-uniform float saturation;
-uniform vec4  gamma;
-uniform vec4  levels;
-uniform float hueshift;
-uniform vec4  chromakey;
-uniform float chromadelta;
-uniform float threshold;
-uniform float lumakey;
-uniform int   nbColors;
-uniform int   invert;
-uniform int   filterid;
-
+// (std140 block matching ImageProcessingShader::Block)
+layout (std140) uniform ImageProcessing
+{
+    vec4  gamma;
+    vec4  levels;
+    vec4  chromakey;
+    float contrast;
+    float brightness;
+    float saturation;
+    float hueshift;
+    float chromadelta;
+    float threshold;
+    float lumakey;
+    int   nbColors;
+    int   invert;
+    int   filterid;
+};
+
+#ifdef CHROMAKEY
 // conversion between rgb and YUV
 const mat4 RGBtoYUV = mat4(0.257,  0.439, -0.148, 0.0,
                            0.504, -0.368, -0.291, 0.0,
                            0.098, -0.071,  0.439, 0.0,
                            0.0625, 0.500,  0.500, 1.0 );
+#endif
 
+#ifdef FILTER_KERNEL
 const mat3 KERNEL[5] = mat3[5]( mat3( 0.0, 0.0, 0.0,
                                       0.0, 1.0, 0.0,
                                       0.0, 0.0, 0.0),
@@ -74,105 +89,20 @@ const mat3 KERNEL[5] = mat3[5]( mat3( 0.0, 0.0, 0.0,
                                       0.0, 1.0, 2.0)
                                 );
 
-vec3 erosion(int N, vec2 filter_step)
-{
-    vec3 minValue = vec3(1.0);
-
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (0.0,0.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (0.0,-1.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (-1.0, 0.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (1.0, 0.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (0.0, 1.0) * filter_step ).rgb, minValue);
-    if (N < 1)
-        return minValue;
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (-1.0, -2.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (0.0,-2.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (1.0,-2.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (-1.0,2.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (0.0, 2.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (1.0, 2.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (-2.0, 1.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (-1.0, 1.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 ( 1.0, 1.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 ( 2.0, 1.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (-2.0, -1.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (-1.0, -1.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 ( 1.0, -1.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 ( 2.0, -1.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (-2.0, 0.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 ( 2.0, 0.0) * filter_step ).rgb, minValue);
-    if (N < 2)
-        return minValue;
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (-1.0, -3.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (0.0,-3.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (1.0,-3.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (-1.0,3.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (0.0, 3.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (1.0, 3.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (-2.0, 2.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 ( 2.0, 2.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (-2.0, -2.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 ( 2.0, -2.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (-3.0, -1.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (3.0, -1.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (-3.0, 1.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 ( 3.0, 1.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 (-3.0, 0.0) * filter_step ).rgb, minValue);
-    minValue = min(texture(iChannel0, texcoord.xy + vec2 ( 3.0, 0.0) * filter_step ).rgb, minValue);
-
-    return minValue;
-}
-
-vec3 dilation(int N, vec2 filter_step)
+vec3 convolution(mat3 kernel, vec2 filter_step)
 {
-    vec3 maxValue = vec3(0.0);
+    int i = 0, j = 0;
+    vec3 sum = vec3(0.0);
 
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (0.0, 0.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (0.0,-1.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (-1.0, 0.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (1.0, 0.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (0.0, 1.0) * filter_step ).rgb, maxValue);
-    if (N < 1)
-        return maxValue;
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (-1.0, -2.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (0.0,-2.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (1.0,-2.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (-1.0,2.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (0.0, 2.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (1.0, 2.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (-2.0, 1.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (-1.0, 1.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 ( 1.0, 1.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 ( 2.0, 1.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (-2.0, -1.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (-1.0, -1.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 ( 1.0, -1.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 ( 2.0, -1.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (-2.0, 0.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 ( 2.0, 0.0) * filter_step ).rgb, maxValue);
-    if (N < 2)
-        return maxValue;
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (-1.0, -3.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (0.0,-3.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (1.0,-3.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (-1.0,3.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (0.0, 3.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (1.0, 3.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (-2.0, 2.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 ( 2.0, 2.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (-2.0, -2.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 ( 2.0, -2.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (-3.0, -1.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (3.0, -1.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (-3.0, 1.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 ( 3.0, 1.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 (-3.0, 0.0) * filter_step ).rgb, maxValue);
-    maxValue = max(texture(iChannel0, texcoord.xy + vec2 ( 3.0, 0.0) * filter_step ).rgb, maxValue);
+    for (i = 0; i<3; ++i)
+        for (j = 0; j<3; ++j)
+            sum += texture(iChannel0, texcoord.xy + filter_step * vec2 (i-1, j-1) ).rgb * kernel[i][j];
 
-    return maxValue;
+    return sum;
 }
+#endif
 
-
+#ifdef FILTER_OPENING
 vec3 opening(vec2 filter_step)
 {
     // 1) erosion
@@ -210,35 +140,26 @@ vec3 opening(vec2 filter_step)
 
     return maxValue;
 }
-
-vec3 convolution(mat3 kernel, vec2 filter_step)
-{
-    int i = 0, j = 0;
-    vec3 sum = vec3(0.0);
-
-    for (i = 0; i<3; ++i)
-        for (j = 0; j<3; ++j)
-            sum += texture(iChannel0, texcoord.xy + filter_step * vec2 (i-1, j-1) ).rgb * kernel[i][j];
-
-    return sum;
-}
+#endif
 
 vec3 apply_filter() {
 
     vec2 filter_step = 1.f / textureSize(iChannel0, 0);
 
-    if (filterid < 1 || filterid > 11)
-        return texture(iChannel0, texcoord.xy).rgb;
-    else if (filterid < 5)
+    // NB: blur, erosion and dilation are applied before by ImageFilter
+#ifdef FILTER_KERNEL
+    if (filterid > 1 && filterid < 5)
         return convolution( KERNEL[filterid], filter_step);
-    else if (filterid < 6)
+#endif
+#ifdef FILTER_OPENING
+    if (filterid == 5)
         return opening(filter_step);
-    else if (filterid < 9)
-        return erosion( filterid - 6 , filter_step);
-    else
-        return dilation( filterid - 9, filter_step);
+#endif
+
+    return texture(iChannel0, texcoord.xy).rgb;
 }
 
+#ifdef HSL
 /*
 ** Hue, saturation, luminance <=> Red Green Blue
 */
@@ -296,7 +217,9 @@ vec3 RGB2HSV( vec3 color )
 
     return hsl;
 }
+#endif
 
+#ifdef CHROMAKEY
 float alphachromakey(vec3 color, vec3 colorKey, float delta)
 {
    // magic values
@@ -313,6 +236,7 @@ float alphachromakey(vec3 color, vec3 colorKey, float delta)
    // tolerance clamping
    return max( (1.0 - step(d, tol.y)), step(tol.x, d) * (d - tol.x) / (tol.y - tol.x));
 }
+#endif
 
 
 void main(void)
@@ -329,44 +253,64 @@ void main(void)
     vec3 transformedRGB;
     transformedRGB = apply_filter();
 
+#ifdef CHROMAKEY
     // chromakey
     alpha -= mix( 0.0, 1.0 - alphachromakey( transformedRGB, chromakey.rgb, chromadelta), float(chromadelta > 0.0001) );
+#endif
 
     // brightness and contrast transformation
     transformedRGB = mix(vec3(0.62), transformedRGB, contrast + 1.0) + brightness;
 
+#ifdef INVERT_RGB
     // RGB invert
     transformedRGB = vec3(float(invert==1)) + ( transformedRGB * vec3(1.0 - 2.0 * float(invert==1)) );
+#endif
 
+#ifdef HSL
     // Convert to HSL
     vec3 transformedHSL = RGB2HSV( transformedRGB );
 
+#ifdef INVERT_LUMA
     // Luminance invert
     transformedHSL.z = float(invert==2) +  transformedHSL.z * (1.0 - 2.0 * float(invert==2) );
+#endif
 
+#ifdef HUESHIFT
     // perform hue shift
     transformedHSL.x = transformedHSL.x + hueshift;
+#endif
 
+#ifdef SATURATION
     // Saturation
     transformedHSL.y *= saturation + 1.0;
+#endif
 
+#ifdef POSTERIZE
     // perform reduction of colors
     transformedHSL = mix( transformedHSL, floor(transformedHSL * vec3(nbColors)) / vec3(nbColors-1),  float( nbColors > 0 ) );
+#endif
 
+#ifdef LUMAKEY
     // luma key
     alpha -= mix( 0.0, step( transformedHSL.z, lumakey ), float(lumakey > EPSILON));
+#endif
 
+#ifdef THRESHOLD
     // level threshold
     transformedHSL = mix( transformedHSL, vec3(0.0, 0.0, 0.95 - step( transformedHSL.z, threshold )), float(threshold > EPSILON));
+#endif
 
     // after operations on HSL, convert back to RGB
     transformedRGB = HSV2RGB(transformedHSL);
+#endif
 
+#ifdef LEVELS
     // apply gamma correction
     transformedRGB = LevelsControl(transformedRGB, levels.x, gamma.rgb * gamma.a, levels.y, levels.z, levels.w);
+#endif
 
     // apply base color and alpha for final fragment color
-    FragColor = vec4(transformedRGB * vertexColor.rgb * color.rgb, clamp(alpha, 0.0, 1.0) );
+    FragColor = vec4(clamp(transformedRGB, 0.0, 1.0) * vertexColor.rgb * color.rgb, clamp(alpha, 0.0, 1.0) );
 
 }
 